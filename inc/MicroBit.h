@@ -31,7 +31,9 @@
 #include "MicroBitDisplay.h"
 
 #include "MicroBitFiber.h"
+#include "MicroBitFiberSync.h"
 #include "MicroBitMessageBus.h"
+#include "MicroBitTimer.h"
 
 #include "MicroBitBLEManager.h"
 
@@ -75,6 +77,11 @@ class MicroBit
     // Periodic callback
     Ticker                  systemTicker;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    // One shot callback, used to wake the processor from tickless idle, and to deliver the first system tick on waking.
+    Timeout                 systemWakeTimer;
+#endif
+
     // I2C Interface
     MicroBitI2C             i2c;
 
@@ -98,6 +105,7 @@ class MicroBit
     MicroBitAccelerometer   accelerometer;
     MicroBitCompass         compass;
     MicroBitThermometer     thermometer;
+    MicroBitTimer           timer;
 
     //An object of available IO pins on the device
     MicroBitIO              io;
@@ -121,6 +129,7 @@ class MicroBit
       * uBit.resetButton; //The resetButton used for soft resets.
       * uBit.accelerometer; //The object that represents the inbuilt accelerometer
       * uBit.compass; //The object that represents the inbuilt compass(magnetometer)
+      * uBit.timer; //One shot and periodic timers, that raise events or call functions
       * uBit.io.P*; //Where P* is P0 to P16, P19 & P20 on the edge connector
       * @endcode
       */
@@ -208,6 +217,36 @@ class MicroBit
       */
     void systemTasks();
 
+    /**
+      * Puts the processor into a power efficient sleep until an interrupt is pending.
+      * Called by the idle thread with interrupts disabled, so that one arriving after it last checked for work wakes the
+      * processor straight away, rather than being serviced first and then slept through. Returns with interrupts disabled.
+      */
+    void systemWait();
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    /**
+      * Replaces the periodic system tick with a single wake up call, so that the processor can sleep through
+      * the ticks in between (see scheduler_tickless_sleep()).
+      *
+      * @param period The time until the wake up call, in microseconds.
+      */
+    void systemTickSuspend(uint32_t period);
+
+    /**
+      * Cancels the wake up call, if it hasn't already happened, and restarts the periodic system tick.
+      *
+      * @param tick If non-zero, a system tick is also delivered straight away (from interrupt context), as one is due.
+      */
+    void systemTickResume(int tick);
+
+    /**
+      * Timer callback used to wake the processor from tickless idle.
+      * Prioritises the idle thread, so that it doesn't go on to sleep if we're called before it has done so.
+      */
+    void systemWake();
+#endif
+
     /**
       * add a component to the array of system components which invocate the systemTick member function during a systemTick
       *
@@ -2,6 +2,7 @@
 #define MICROBIT_BUTTON_H
 
 #include "mbed.h"
+#include "MicroBitConfig.h"
 #include "MicroBitComponent.h"
 #include "MicroBitEvent.h"
 
@@ -24,6 +25,7 @@
 #define MICROBIT_BUTTON_STATE_HOLD_TRIGGERED    2
 #define MICROBIT_BUTTON_STATE_CLICK             4
 #define MICROBIT_BUTTON_STATE_LONG_CLICK        8
+#define MICROBIT_BUTTON_STATE_WAKE              16
 
 #define MICROBIT_BUTTON_SIGMA_MIN               0
 #define MICROBIT_BUTTON_SIGMA_MAX               12
@@ -47,6 +49,9 @@ class MicroBitButton : public MicroBitComponent
 {
     PinName name;                                           // mbed pin name of this pin.
     DigitalIn pin;                                          // The mbed object looking after this pin at any point in time (may change!).
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    InterruptIn wake;                                       // Raises an interrupt when the button is pressed, to wake the processor from tickless idle.
+#endif
 
     unsigned long downStartTime;                            // used to store the current system clock when a button down event occurs
     uint8_t sigma;                                          // integration of samples over time. We use this for debouncing, and noise tolerance for touch sensing
@@ -96,6 +101,20 @@ class MicroBitButton : public MicroBitComponent
       */
     virtual void systemTick();
 
+    /**
+      * Determines when we next need to be called, so that the system tick can be suspended while the device is idle.
+      * @return MICROBIT_SYSTEM_TICK_NONE if the button is released and settled, or 0 otherwise.
+      */
+    virtual unsigned long nextSystemTick();
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    /**
+      * Interrupt handler for a button press. Ensures the button is sampled on the next system tick, even if the
+      * processor was about to suspend it.
+      */
+    void onWake();
+#endif
+
     /**
       * Destructor for MicroBitButton, so that we deregister ourselves as a systemComponent
       */
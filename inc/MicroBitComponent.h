@@ -44,10 +44,16 @@
 #define MICROBIT_ID_GESTURE             27          // Gesture events
 
 #define MICROBIT_ID_THERMOMETER         28
+#define MICROBIT_ID_SCHEDULER           29          // Fiber scheduler events
+#define MICROBIT_ID_MESSAGE_BUS         30          // Message bus events
+#define MICROBIT_ID_TIMER               31          // Timer events (values are chosen by the application)
 
 #define MICROBIT_ID_NOTIFY              1023          // Notfication channel, for general purpose synchronisation
 #define MICROBIT_ID_NOTIFY_ONE          1022          // Notfication channel, for general purpose synchronisation
 
+// Value returned by nextSystemTick() when a component has no need for further system ticks.
+#define MICROBIT_SYSTEM_TICK_NONE       0xFFFFFFFF
+
 class MicroBitComponent
 {
     protected:
@@ -93,6 +99,19 @@ class MicroBitComponent
         return 0;
     }
 
+    /**
+      * When added to the systemTickComponents array, this function will be called to determine
+      * when the component next needs its systemTick member function to be called.
+      * This allows the system tick to be suspended while the device is idle (see MICROBIT_FIBER_TICKLESS).
+      * @return 0 if the component needs to be called on every system tick, the system time (in milliseconds) at
+      * which it next needs to be called, or MICROBIT_SYSTEM_TICK_NONE if it has no need to be called at all.
+      * @note override this if your component can tolerate missing system ticks while the device is idle.
+      */
+    virtual unsigned long nextSystemTick()
+    {
+        return 0;
+    }
+
     virtual ~MicroBitComponent()
     {
 
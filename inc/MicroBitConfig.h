@@ -7,6 +7,22 @@
 
 #include "mbed.h"
 
+//
+// Host configuration
+//
+
+// Set to '1' when building the runtime to run natively on an x86-64 Linux host, rather than a micro:bit.
+// This is defined by MicroBitHost.h, which host builds force include ahead of every source file.
+#ifndef MICROBIT_HOST
+#define MICROBIT_HOST           0
+#endif
+
+// The type of a processor register, and so of the addresses held in a fiber's saved context.
+// MicroBitHost.h widens this to 64 bits for host builds.
+#ifndef PROCESSOR_WORD_TYPE
+#define PROCESSOR_WORD_TYPE     uint32_t
+#endif
+
 //
 // Memory configuration 
 //
@@ -85,6 +101,116 @@
 #define FIBER_TICK_PERIOD_MS            6
 #endif
 
+// The default size of the dedicated stack given to fibers created with create_dedicated_fiber() (bytes).
+// n.b. Interrupt handlers execute on the stack of the currently running fiber, so this must also
+// accommodate the deepest interrupt stack expected (including the BLE stack, if enabled).
+#ifndef MICROBIT_FIBER_DEDICATED_STACK_SIZE
+#define MICROBIT_FIBER_DEDICATED_STACK_SIZE     1024
+#endif
+
+// Enable/Disable pooling of fiber stack buffers.
+// When enabled, the buffers used to hold the stacks of descheduled fibers are drawn from a small number
+// of size classes, and returned to a pool when no longer needed rather than to the heap.
+// This trades RAM for less heap churn: up to MICROBIT_FIBER_STACK_POOL_LIMIT bytes of unused buffers may be
+// held back from the heap, plus a few bytes per size class for the pool itself and its statistics.
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_STACK_POOL
+#define MICROBIT_FIBER_STACK_POOL               0
+#endif
+
+// The size of the smallest class of pooled stack buffer (bytes).
+// Each subsequent size class is twice the size of the previous one.
+#ifndef MICROBIT_FIBER_STACK_POOL_MIN_SIZE
+#define MICROBIT_FIBER_STACK_POOL_MIN_SIZE      128
+#endif
+
+// The number of size classes of pooled stack buffer.
+// The default of 4 classes gives buffers of 128, 256, 512 and 1024 bytes.
+// Larger stacks are allocated directly from the heap.
+#ifndef MICROBIT_FIBER_STACK_POOL_CLASSES
+#define MICROBIT_FIBER_STACK_POOL_CLASSES       4
+#endif
+
+// The maximum amount of memory held in the pool of unused stack buffers (bytes).
+// Buffers released once this limit is reached are returned to the heap.
+#ifndef MICROBIT_FIBER_STACK_POOL_LIMIT
+#define MICROBIT_FIBER_STACK_POOL_LIMIT         1024
+#endif
+
+// The number of priority levels in the fiber scheduler.
+// Runnable fibers of a higher priority are always scheduled ahead of those of a lower priority.
+// Fibers of the same priority are scheduled round robin.
+#ifndef MICROBIT_FIBER_PRIORITY_LEVELS
+#define MICROBIT_FIBER_PRIORITY_LEVELS          4
+#endif
+
+// The priority given to fibers when they are created, unless otherwise specified.
+// Must be less than MICROBIT_FIBER_PRIORITY_LEVELS.
+#ifndef MICROBIT_FIBER_DEFAULT_PRIORITY
+#define MICROBIT_FIBER_DEFAULT_PRIORITY         1
+#endif
+
+// The maximum time a runnable fiber waits behind fibers of a higher priority before it is scheduled anyway (ms).
+// This prevents busy high priority fibers from starving lower priority ones.
+// Set to '0' to disable ageing, and schedule by strict priority.
+#ifndef MICROBIT_FIBER_PRIORITY_AGEING_MS
+#define MICROBIT_FIBER_PRIORITY_AGEING_MS       0
+#endif
+
+// The maximum time a fiber may run without yielding before the scheduler raises a watchdog event (ms).
+// As scheduling is cooperative, a fiber that never sleeps or blocks starves every other fiber and the idle tasks.
+// A MICROBIT_SCHEDULER_EVT_WATCHDOG event is raised once each time a fiber exceeds this budget,
+// and the offending fiber can be found using scheduler_watchdog_fiber().
+// Set to '0' to disable the watchdog.
+#ifndef MICROBIT_FIBER_WATCHDOG_MS
+#define MICROBIT_FIBER_WATCHDOG_MS              0
+#endif
+
+// Enable/Disable earliest deadline first scheduling.
+// When enabled, runnable fibers with a deadline (such as those created by create_periodic_fiber()) are scheduled
+// in order of deadline, ahead of any other fibers of the same priority. Fibers with no deadline are scheduled round robin.
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_EDF
+#define MICROBIT_FIBER_EDF                      0
+#endif
+
+// Enable/Disable per fiber runtime statistics.
+// When enabled, each fiber records the number of times it has been scheduled, the time it has spent running,
+// the deepest stack it has used and the number of fibers forked on its behalf. All fibers can then be
+// enumerated using fiber_list().
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_STATISTICS
+#define MICROBIT_FIBER_STATISTICS               0
+#endif
+
+// Enable/Disable tickless idle mode.
+// When enabled, the periodic system tick is suspended whenever the processor is idle and no system component
+// requires it. The processor then sleeps until the next fiber is due to wake (or an interrupt occurs),
+// and the system time is brought up to date on wake.
+// Set '1' to enable.
+#ifndef MICROBIT_FIBER_TICKLESS
+#define MICROBIT_FIBER_TICKLESS         0
+#endif
+
+// The longest period the processor will sleep for in tickless idle mode (milliseconds).
+// Bounds the time between updates of the system time when nothing else is scheduled.
+#ifndef MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS
+#define MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS    60000
+#endif
+
+// The number of fiber local storage slots available on each fiber.
+// Each slot holds a single pointer, and costs 4 bytes of RAM per fiber. Slots are allocated using fiber_local_alloc().
+// Set to '0' to disable fiber local storage.
+#ifndef MICROBIT_FIBER_LOCAL_SLOTS
+#define MICROBIT_FIBER_LOCAL_SLOTS              0
+#endif
+
+// The maximum number of calls that can be deferred from interrupt context using scheduler_defer(),
+// before they are run by the idle fiber.
+#ifndef MICROBIT_DEFERRED_CALL_QUEUE_SIZE
+#define MICROBIT_DEFERRED_CALL_QUEUE_SIZE       8
+#endif
+
 //
 // Message Bus:
 // Default behaviour for event handlers, if not specified in the listen() call
@@ -106,6 +232,75 @@
 #ifndef MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH
 #define MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH        10
 #endif
+
+//
+// The number of lists used to index event listeners by source ID.
+// Each event is only matched against the listeners in the list for its ID, and those registered for MICROBIT_ID_ANY.
+// Each list costs 4 bytes of RAM.
+//
+#ifndef MESSAGE_BUS_LISTENER_BUCKETS
+#define MESSAGE_BUS_LISTENER_BUCKETS                8
+#endif
+
+//
+// The number of listeners allocated from the heap at a time, when the pool of unused listeners is empty.
+// Listeners are recycled through the pool when removed, rather than being returned to the heap.
+// Set to '0' to allocate each listener from the heap individually.
+//
+#ifndef MESSAGE_BUS_LISTENER_POOL_CHUNK
+#define MESSAGE_BUS_LISTENER_POOL_CHUNK             4
+#endif
+
+//
+// The maximum number of events that can be given a specific policy (such as coalescing) using setEventPolicy().
+//
+#ifndef MESSAGE_BUS_EVENT_POLICIES
+#define MESSAGE_BUS_EVENT_POLICIES                  8
+#endif
+
+//
+// The number of priority lanes in the event queue (at most 16).
+// Queued events are processed from the highest lane first, and in order within each lane.
+// When the queue is full, an event can displace the newest event on a lower lane.
+//
+#ifndef MESSAGE_BUS_PRIORITY_LANES
+#define MESSAGE_BUS_PRIORITY_LANES                  2
+#endif
+
+//
+// Enable/Disable event queue statistics.
+// When enabled, the message bus counts the events it queues, drops and coalesces, records the deepest the queue
+// has been, and keeps a histogram of the time events wait in the queue. See MicroBitMessageBus::getStatistics().
+// A MICROBIT_MESSAGE_BUS_EVT_DROPPED event is also raised whenever events have been dropped.
+// Set '1' to enable.
+//
+#ifndef MESSAGE_BUS_STATISTICS
+#define MESSAGE_BUS_STATISTICS                      0
+#endif
+
+//
+// Enable/Disable the event trace recorder.
+// When enabled, the message bus records each event it is sent, and each time it delivers an event to its listeners,
+// in a ring buffer of the last MESSAGE_BUS_TRACE_DEPTH records. The trace can be sent over serial using
+// MicroBitSerial::sendEventTrace(), and decoded using utils/decode_event_trace.py.
+// Each record costs 12 bytes of RAM.
+// Set '1' to enable.
+//
+#ifndef MESSAGE_BUS_TRACE
+#define MESSAGE_BUS_TRACE                           0
+#endif
+
+#ifndef MESSAGE_BUS_TRACE_DEPTH
+#define MESSAGE_BUS_TRACE_DEPTH                     32
+#endif
+
+//
+// The number of buckets in the histogram of event queue residency times.
+// Bucket n counts events that waited less than (FIBER_TICK_PERIOD_MS << n) milliseconds. The last bucket counts all others.
+//
+#ifndef MESSAGE_BUS_RESIDENCY_BUCKETS
+#define MESSAGE_BUS_RESIDENCY_BUCKETS               8
+#endif
 //
 // Core micro:bit services
 //
@@ -124,6 +319,12 @@
 #define MICROBIT_IDLE_COMPONENTS        6
 #endif
 
+// The number of timers that MicroBitTimer initially has room for.
+// Space for further timers is allocated from the heap as it is needed, doubling each time.
+#ifndef MICROBIT_TIMER_INITIAL_CAPACITY
+#define MICROBIT_TIMER_INITIAL_CAPACITY 8
+#endif
+
 //
 // BLE options
 //
@@ -256,6 +256,12 @@ public:
       */
     virtual void systemTick();
 
+    /**
+      * Determines when the display next needs to be strobed.
+      * @return 0 if the display is enabled, MICROBIT_SYSTEM_TICK_NONE otherwise.
+      */
+    virtual unsigned long nextSystemTick();
+
     /**
      * Prints the given character to the display, if it is not in use.
      *
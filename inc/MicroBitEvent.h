@@ -7,7 +7,8 @@ enum MicroBitEventLaunchMode
 {
     CREATE_ONLY,                        
     CREATE_AND_QUEUE,
-    CREATE_AND_FIRE
+    CREATE_AND_FIRE,
+    CREATE_AND_QUEUE_PRIORITY
 };
 
 #define MICROBIT_EVENT_DEFAULT_LAUNCH_MODE     CREATE_AND_QUEUE
@@ -36,6 +37,7 @@ class MicroBitEvent
       * CREATE_ONLY: MicroBitEvent is initialised, and no further processing takes place.
       * CREATE_AND_QUEUE: MicroBitEvent is initialised, and queued on the MicroBitMessageBus.
       * CREATE_AND_FIRE: MicroBitEvent is initialised, and its event handlers are immediately fired (not suitable for use in interrupts!).
+      * CREATE_AND_QUEUE_PRIORITY: MicroBitEvent is initialised, and queued on the highest priority lane of the MicroBitMessageBus.
       * 
       * Example: Create and launch an event using the default configuration
       * @code 
@@ -14,9 +14,6 @@
 #include "MicroBitConfig.h"
 #include "MicroBitEvent.h"
 
-// TODO: Consider a split mode scheduler, that monitors used stack size, and maintains a dedicated, persistent
-// stack for any long lived fibers with large stack
-
 // Fiber Scheduler Flags
 #define MICROBIT_FLAG_DATA_READY 	        0x01 
 
@@ -25,6 +22,22 @@
 #define MICROBIT_FIBER_FLAG_PARENT          0x02 
 #define MICROBIT_FIBER_FLAG_CHILD           0x04 
 #define MICROBIT_FIBER_FLAG_DO_NOT_PAGE     0x08
+#define MICROBIT_FIBER_FLAG_DEDICATED_STACK 0x10
+
+// Fiber priorities. Any value less than MICROBIT_FIBER_PRIORITY_LEVELS may be used.
+#define MICROBIT_FIBER_PRIORITY_LOWEST      0
+#define MICROBIT_FIBER_PRIORITY_HIGHEST     (MICROBIT_FIBER_PRIORITY_LEVELS - 1)
+
+// Scheduler events
+#define MICROBIT_SCHEDULER_EVT_WATCHDOG     1
+
+// Fiber States, as reported by fiber_state()
+#define MICROBIT_FIBER_STATE_RUNNING        1
+#define MICROBIT_FIBER_STATE_RUNNABLE       2
+#define MICROBIT_FIBER_STATE_SLEEPING       3
+#define MICROBIT_FIBER_STATE_WAITING        4
+#define MICROBIT_FIBER_STATE_POOLED         5
+#define MICROBIT_FIBER_STATE_IDLE           6
 
 /**
   *  Thread Context for an ARM Cortex M0 core.
@@ -35,22 +48,22 @@
   */
 struct Cortex_M0_TCB
 {
-    uint32_t R0;
-    uint32_t R1;
-    uint32_t R2;
-    uint32_t R3;
-    uint32_t R4;
-    uint32_t R5;
-    uint32_t R6;
-    uint32_t R7;
-    uint32_t R8;
-    uint32_t R9;
-    uint32_t R10;
-    uint32_t R11;
-    uint32_t R12;
-    uint32_t SP;
-    uint32_t LR;
-    uint32_t stack_base;                
+    PROCESSOR_WORD_TYPE R0;
+    PROCESSOR_WORD_TYPE R1;
+    PROCESSOR_WORD_TYPE R2;
+    PROCESSOR_WORD_TYPE R3;
+    PROCESSOR_WORD_TYPE R4;
+    PROCESSOR_WORD_TYPE R5;
+    PROCESSOR_WORD_TYPE R6;
+    PROCESSOR_WORD_TYPE R7;
+    PROCESSOR_WORD_TYPE R8;
+    PROCESSOR_WORD_TYPE R9;
+    PROCESSOR_WORD_TYPE R10;
+    PROCESSOR_WORD_TYPE R11;
+    PROCESSOR_WORD_TYPE R12;
+    PROCESSOR_WORD_TYPE SP;
+    PROCESSOR_WORD_TYPE LR;
+    PROCESSOR_WORD_TYPE stack_base;
 };
 
 /**
@@ -60,16 +73,135 @@ struct Cortex_M0_TCB
 struct Fiber
 {
     Cortex_M0_TCB tcb;                  // Thread context when last scheduled out.
-    uint32_t stack_bottom;              // The start sddress of this Fiber's stack. Stack is heap allocated, and full descending.
-    uint32_t stack_top;                 // The end address of this Fiber's stack.
+    PROCESSOR_WORD_TYPE stack_bottom;   // The start sddress of this Fiber's stack. Stack is heap allocated, and full descending.
+                                        // For a paged fiber this holds a copy of the stack while the fiber is descheduled.
+                                        // For a fiber with a dedicated stack, the fiber executes directly on this memory.
+    PROCESSOR_WORD_TYPE stack_top;      // The end address of this Fiber's stack.
     uint32_t context;                   // Context specific information. 
     uint32_t flags;                     // Information about this fiber.
     Fiber **queue;                      // The queue this fiber is stored on.
     Fiber *next, *prev;                 // Position of this Fiber on the run queues.
+    uint32_t priority;                  // The run queue this fiber is placed on when runnable. Higher values are scheduled first.
+    uint32_t generation;                // Incremented each time this fiber completes, to detect reuse from the fiber pool.
+    Fiber *joiners;                     // Fibers blocked waiting for this fiber to complete.
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    unsigned long deadline;             // The time by which this fiber should complete its current work, or 0 if it has no deadline.
+#endif
+
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+    void *local[MICROBIT_FIBER_LOCAL_SLOTS];    // Fiber local storage. See fiber_local_alloc().
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    uint32_t switches;                  // The number of times this fiber has been scheduled in.
+    uint32_t run_time;                  // The total time this fiber has spent running (ms).
+    uint32_t max_stack_depth;           // The deepest stack observed when this fiber was scheduled out (bytes).
+    uint32_t forks;                     // The number of fibers forked on block on behalf of this fiber.
+    Fiber *list_next;                   // The next fiber in the list of all fibers.
+#endif
+};
+
+/**
+  * A queue of fibers blocked waiting on a specific event.
+  */
+struct FiberWaitQueue
+{
+    uint16_t id;                        // The ID of the event the fibers are waiting on.
+    uint16_t value;                     // The VALUE of the event the fibers are waiting on.
+    Fiber *queue;                       // The fibers waiting on this event.
+    FiberWaitQueue *next;               // The next wait queue in the scheduler's list.
+};
+
+/**
+  * A function run periodically by a fiber, as created by create_periodic_fiber().
+  * Each run is released at a fixed multiple of the period from the first, so the sampling rate does not drift
+  * however long each run takes. Each run is due to complete by the time of the next release.
+  */
+struct FiberPeriodicTask
+{
+    void (*entry_fn)(void *);           // The function to run each period.
+    void *param;                        // The parameter to pass to the function.
+    unsigned long period;               // The time between releases (ms), or 0 once the task has been cancelled.
+    unsigned long release;              // The time at which the current (or next) run was released.
+    uint32_t missed;                    // The number of deadlines missed, including any releases skipped as a result.
+    Fiber *fiber;                       // The fiber running the task.
+};
+
+/**
+  * A function call deferred from interrupt context, to be run by the idle fiber.
+  */
+struct FiberDeferredCall
+{
+    void (*fn)(void *);                 // The function to call.
+    void *arg;                          // The parameter to pass to the function.
 };
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+/**
+  * Usage statistics for the pool of fiber stack buffers.
+  * Useful to determine the best size classes for a given workload.
+  */
+struct FiberStackPoolStatistics
+{
+    uint32_t hits[MICROBIT_FIBER_STACK_POOL_CLASSES];           // Number of buffers of each size class supplied from the pool.
+    uint32_t misses[MICROBIT_FIBER_STACK_POOL_CLASSES + 1];     // Number of buffers of each size class allocated from the heap. The last entry counts stacks larger than any class.
+    uint32_t pooled;                                            // The number of bytes currently held in the pool.
+};
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Statistics on the cost of fork on block, as used by invoke().
+  * Functions that complete without blocking cost nothing more than a function call.
+  * Those that block are forked onto a new fiber, at the cost of copying their stack.
+  */
+struct FiberInvokeStatistics
+{
+    uint32_t invocations;               // The number of functions run speculatively in fork on block context.
+    uint32_t forks;                     // The number of those functions that blocked, and so were forked onto a new fiber.
+    uint32_t fork_bytes;                // The total number of bytes of stack copied when forking.
+    uint32_t max_fork_bytes;            // The largest number of bytes of stack copied by a single fork.
+};
+#endif
+
 extern Fiber *currentFiber;
 
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+/**
+  * Allocates a fiber local storage slot.
+  * Every fiber has its own value for the slot, which is NULL until set using fiber_local_set().
+  * Fibers forked on block start with all their slots NULL.
+  *
+  * @param destructor A function to call with the value of the slot when a fiber completes (optional).
+  * It is only called if the value is not NULL.
+  * @return The index of the slot allocated, or MICROBIT_NO_RESOURCES if all MICROBIT_FIBER_LOCAL_SLOTS are in use.
+  */
+int fiber_local_alloc(void (*destructor)(void *) = NULL);
+
+/**
+  * Retrieves the value of a fiber local storage slot for the current fiber.
+  *
+  * @param slot A slot index, as returned by fiber_local_alloc().
+  * @return The value of the slot, or NULL if it has not been set.
+  */
+inline void *fiber_local_get(int slot)
+{
+    return currentFiber->local[slot];
+}
+
+/**
+  * Sets the value of a fiber local storage slot for the current fiber.
+  *
+  * @param slot A slot index, as returned by fiber_local_alloc().
+  * @param value The value to store.
+  */
+inline void fiber_local_set(int slot, void *value)
+{
+    currentFiber->local[slot] = value;
+}
+#endif
+
 /**
   * Initialises the Fiber scheduler. 
   * Creates a Fiber context around the calling thread, and adds it to the run queue as the current thread.
@@ -92,12 +224,18 @@ void launch_new_fiber(void (*ep)(void), void (*cp)(void))
 #ifdef __GCC__
     __attribute__((naked))
 #endif
+#if CONFIG_ENABLED(MICROBIT_HOST)
+    __attribute__((force_align_arg_pointer))
+#endif
 ;
 
 void launch_new_fiber_param(void (*ep)(void *), void (*cp)(void *), void *pm)
 #ifdef __GCC__
     __attribute__((naked))
 #endif
+#if CONFIG_ENABLED(MICROBIT_HOST)
+    __attribute__((force_align_arg_pointer))
+#endif
 ;
 
 /**
@@ -105,9 +243,10 @@ void launch_new_fiber_param(void (*ep)(void *), void (*cp)(void *), void *pm)
   *
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The new Fiber, or NULL if the parameters are invalid or there is insufficient memory.
   */
-Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = release_fiber);
+Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = release_fiber, int priority = MICROBIT_FIBER_DEFAULT_PRIORITY);
 
 
 /**
@@ -116,9 +255,70 @@ Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void) = releas
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param param an untyped parameter passed into the entry_fn anf completion_fn.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The new Fiber, or NULL if the parameters are invalid or there is insufficient memory.
+  */
+Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *) = release_fiber, int priority = MICROBIT_FIBER_DEFAULT_PRIORITY);
+
+/**
+  * Creates a new Fiber with its own dedicated stack, and launches it.
+  *
+  * Normal fibers share the system stack, and have their stack copied in and out of a heap buffer each time
+  * they are scheduled. A fiber with a dedicated stack instead executes directly on a heap allocated stack,
+  * so context switches to and from it only need to save and restore registers. This suits long lived fibers
+  * with deep stacks, at the cost of permanently reserving stack_size bytes of heap for the fiber.
+  *
+  * n.b. A fiber with a dedicated stack never uses fork on block. Any call to invoke() from such a fiber
+  * always creates a new fiber.
+  *
+  * @param entry_fn The function the new Fiber will begin execution in.
+  * @param stack_size The size of the fiber's stack, in bytes. This must also accommodate any interrupt handlers.
+  * @param completion_fn The function called when the thread completes execution of entry_fn.
+  * @return The new Fiber. If the stack could not be allocated, the fiber is still created, but uses the system stack as normal.
   */
-Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *) = release_fiber);
+Fiber *create_dedicated_fiber(void (*entry_fn)(void), uint32_t stack_size = MICROBIT_FIBER_DEDICATED_STACK_SIZE, void (*completion_fn)(void) = release_fiber);
+
+/**
+  * Creates a new parameterised Fiber with its own dedicated stack, and launches it.
+  *
+  * @param entry_fn The function the new Fiber will begin execution in.
+  * @param param an untyped parameter passed into the entry_fn anf completion_fn.
+  * @param stack_size The size of the fiber's stack, in bytes. This must also accommodate any interrupt handlers.
+  * @param completion_fn The function called when the thread completes execution of entry_fn.
+  * @return The new Fiber. If the stack could not be allocated, the fiber is still created, but uses the system stack as normal.
+  */
+Fiber *create_dedicated_fiber(void (*entry_fn)(void *), void *param, uint32_t stack_size = MICROBIT_FIBER_DEDICATED_STACK_SIZE, void (*completion_fn)(void *) = release_fiber);
+
+/**
+  * Creates a new Fiber that calls the given function once every period, and launches it.
+  * The first call is made immediately. If a call completes after the next is due, a deadline is missed,
+  * and any releases that have already passed are skipped rather than run back to back.
+  *
+  * Example:
+  * @code
+  * void sample(void *)
+  * {
+  *     uBit.accelerometer.getX();
+  * }
+  *
+  * FiberPeriodicTask *task = create_periodic_fiber(sample, NULL, 20);
+  * @endcode
+  *
+  * @param entry_fn The function to call each period.
+  * @param param an untyped parameter passed into the entry_fn.
+  * @param period The time between calls, in milliseconds.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The task, or NULL if the parameters are invalid or there is insufficient memory.
+  */
+FiberPeriodicTask *create_periodic_fiber(void (*entry_fn)(void *), void *param, unsigned long period, int priority = MICROBIT_FIBER_DEFAULT_PRIORITY);
+
+/**
+  * Stops a task created by create_periodic_fiber().
+  * The task's fiber completes at its next release, when the task is freed.
+  *
+  * @param task The task to stop. This must not be used once this function has been called.
+  */
+void cancel_periodic_fiber(FiberPeriodicTask *task);
 
 
 /**
@@ -140,6 +340,16 @@ void schedule();
   */
 void fiber_sleep(unsigned long t);
 
+/**
+  * Blocks the calling thread until the given system time.
+  * Unlike fiber_sleep(), the wake up time does not depend on when the call is made, so loops
+  * that sleep until a fixed multiple of a period do not drift.
+  *
+  * @param t The system time at which to wake up, in milliseconds (as given by ticks).
+  * If this has already passed, the fiber is woken at the next scheduler tick.
+  */
+void fiber_sleep_until(unsigned long t);
+
 /**
   * Timer callback. Called from interrupt context, once every FIBER_TICK_PERIOD_MS milliseconds.
   * Simply checks to determine if any fibers blocked on the sleep queue need to be woken up 
@@ -147,6 +357,57 @@ void fiber_sleep(unsigned long t);
   */
 void scheduler_tick();
 
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+/**
+  * Determines which fiber most recently ran for longer than MICROBIT_FIBER_WATCHDOG_MS without yielding.
+  *
+  * Example:
+  * @code
+  * void onWatchdog(MicroBitEvent)
+  * {
+  *     Fiber *f = scheduler_watchdog_fiber();
+  * }
+  *
+  * uBit.MessageBus.listen(MICROBIT_ID_SCHEDULER, MICROBIT_SCHEDULER_EVT_WATCHDOG, onWatchdog, MESSAGE_BUS_LISTENER_IMMEDIATE);
+  * @endcode
+  *
+  * @return The offending fiber, or NULL if the watchdog has never been triggered.
+  */
+Fiber *scheduler_watchdog_fiber();
+#endif
+
+/**
+  * Determines when the scheduler next needs to wake a sleeping fiber.
+  * @return The system time (in milliseconds) at which the next sleeping fiber is due to wake,
+  * or MICROBIT_SYSTEM_TICK_NONE if there are no sleeping fibers.
+  */
+unsigned long scheduler_next_wakeup();
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+/**
+  * Determines the time by which the processor must be woken, if the system tick is suspended.
+  * This is when the next sleeping fiber is due to wake, or when any system component needs its next tick,
+  * whichever is sooner.
+  *
+  * @return That time, or the current system time if there is work to do now: a runnable fiber, a deferred call,
+  * or an idle component with work pending.
+  */
+unsigned long scheduler_tickless_deadline();
+
+/**
+  * Suspends the system tick and puts the processor into a power efficient sleep until the next sleeping fiber is due
+  * to wake or a system component needs its next tick (but for no longer than MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS),
+  * or until an interrupt occurs. The system time is then brought up to date, and the system tick restarted.
+  *
+  * Nothing is done if there is work to do, or if the processor is due to be woken within a couple of ticks anyway.
+  * Only suspending the system tick and sleeping are device specific (see MicroBit::systemTickSuspend(),
+  * MicroBit::systemTickResume() and MicroBit::systemWait()).
+  *
+  * @return 1 if the system tick was suspended, 0 otherwise.
+  */
+int scheduler_tickless_sleep();
+#endif
+
 /**
   * Blocks the calling thread until the specified event is raised.
   * The calling thread will be immediatley descheduled, and placed onto a 
@@ -160,6 +421,57 @@ void scheduler_tick();
   */
 void fiber_wait_for_event(uint16_t id, uint16_t value);
 
+/**
+  * Blocks the calling thread on the given wait queue, until it is woken by fiber_wake_one() or fiber_wake_all().
+  * This is the building block for synchronisation primitives that park fibers on their own queues,
+  * rather than on the message bus.
+  *
+  * @param queue The wait queue to block on.
+  */
+void fiber_wait_on(Fiber **queue);
+
+/**
+  * Blocks the calling thread until the given fiber completes.
+  * Fibers are recycled via the fiber pool once they complete, so the caller identifies the fiber by
+  * both its context and its generation (as it was when the fiber was created). If the generation has
+  * since changed, the fiber has already completed and this call returns immediately.
+  *
+  * @param f The fiber to wait for.
+  * @param generation The generation of the fiber to wait for.
+  * @return MICROBIT_OK once the fiber has completed, or MICROBIT_INVALID_PARAMETER if f is NULL or is the calling fiber.
+  */
+int fiber_join(Fiber *f, uint32_t generation);
+
+/**
+  * Changes the priority of the given fiber. If the fiber is runnable, it is moved to the tail of its new run queue.
+  *
+  * @param f The fiber to change.
+  * @param priority The new priority, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if f is NULL or the priority is out of range.
+  *
+  * Example:
+  * @code
+  * fiber_set_priority(currentFiber, MICROBIT_FIBER_PRIORITY_HIGHEST);
+  * @endcode
+  */
+int fiber_set_priority(Fiber *f, int priority);
+
+/**
+  * Makes the fiber at the head of the given wait queue runnable.
+  *
+  * @param queue The wait queue to wake a fiber from.
+  * @return The fiber that was woken, or NULL if the queue was empty.
+  */
+Fiber *fiber_wake_one(Fiber **queue);
+
+/**
+  * Makes every fiber on the given wait queue runnable.
+  *
+  * @param queue The wait queue to wake fibers from.
+  * @return The number of fibers that were woken.
+  */
+int fiber_wake_all(Fiber **queue);
+
 /**
   * Executes the given function asynchronously if necessary.
   * 
@@ -200,19 +512,107 @@ int invoke(void (*entry_fn)(void *), void *param);
   */
 inline void verify_stack_size(Fiber *f);
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
 /**
-  * Event callback. Called from the message bus whenever an event is raised. 
-  * Checks to determine if any fibers blocked on the wait queue need to be woken up 
-  * and made runnable due to the event.
+  * Provides usage statistics for the pool of fiber stack buffers.
+  * @return The statistics gathered since power on.
+  */
+const FiberStackPoolStatistics *fiber_stack_pool_statistics();
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Provides statistics on the cost of fork on block.
+  * The number of functions that completed inline is invocations - forks.
+  * @return The statistics gathered since power on.
+  */
+const FiberInvokeStatistics *fiber_invoke_statistics();
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Provides access to every fiber known to the scheduler, whatever its state.
+  * Subsequent fibers can be found by following the list_next field of each fiber.
+  *
+  * Example:
+  * @code
+  * for (Fiber *f = fiber_list(); f != NULL; f = f->list_next)
+  *     uBit.serial.printf("%d: %d switches, %d ms\r\n", fiber_state(f), f->switches, f->run_time);
+  * @endcode
+  *
+  * @return The first fiber in the list.
+  */
+Fiber *fiber_list();
+#endif
+
+/**
+  * Determines the current state of the given fiber.
+  * @param f The fiber to inspect.
+  * @return One of MICROBIT_FIBER_STATE_RUNNING, MICROBIT_FIBER_STATE_RUNNABLE, MICROBIT_FIBER_STATE_SLEEPING,
+  * MICROBIT_FIBER_STATE_WAITING, MICROBIT_FIBER_STATE_POOLED or MICROBIT_FIBER_STATE_IDLE.
+  */
+int fiber_state(Fiber *f);
+
+/**
+  * Event callback. Called from the message bus whenever an event is raised on the NOTIFY_ONE channel.
+  * Wakes up the first fiber waiting on the NOTIFY channel with the same value (or any value), and makes it runnable.
+  *
+  * @param evt The event raised.
   */
 void scheduler_event(MicroBitEvent evt);
 
+/**
+  * Event callback. Called from the message bus whenever an event is raised that one or more fibers have waited on.
+  * Wakes up all the fibers blocked on the given wait queue, and makes them runnable.
+  *
+  * @param evt The event raised.
+  * @param param The wait queue associated with the event.
+  */
+void scheduler_wait_event(MicroBitEvent evt, void *param);
+
 /**
   * Determines if any fibers are waiting to be scheduled.
   * @return The number of fibers currently on the run queue
   */
 int scheduler_runqueue_empty();
 
+/**
+  * Defers a function call until the idle fiber next runs, before any idle components are serviced.
+  * This allows interrupt handlers to hand off work in a handful of cycles, without using the heap
+  * or the message bus. Safe to call from interrupt context.
+  *
+  * Deferred functions should not block: one that does is moved onto a fiber of its own (see invoke()),
+  * and completes after any calls deferred after it.
+  *
+  * @param fn The function to call.
+  * @param arg The parameter to pass to the function.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL, or MICROBIT_NO_RESOURCES
+  * if MICROBIT_DEFERRED_CALL_QUEUE_SIZE calls are already waiting.
+  *
+  * Example:
+  * @code
+  * void onDataReady(void *driver)
+  * {
+  *     ((MyDriver *) driver)->read();
+  * }
+  *
+  * void MyDriver::interrupt()
+  * {
+  *     scheduler_defer(onDataReady, this);
+  * }
+  * @endcode
+  */
+int scheduler_defer(void (*fn)(void *), void *arg);
+
+/**
+  * Runs all function calls deferred using scheduler_defer(), in the order in which they were deferred.
+  * Normally called by the idle fiber.
+  * Each call is made using invoke(), so that one that blocks does not block the caller.
+  *
+  * @return The number of calls run.
+  */
+int scheduler_run_deferred();
+
 /**
   * Utility function to add the currenty running fiber to the given queue. 
   * Perform a simple add at the head, to avoid complexity,
@@ -224,6 +624,15 @@ int scheduler_runqueue_empty();
   */
 void queue_fiber(Fiber *f, Fiber **queue);
 
+/**
+  * Utility function to add the given fiber to the sleep queue.
+  * The sleep queue is held in strict order of wake up time, so that scheduler_tick() need only
+  * inspect the fibers that are actually due.
+  *
+  * @param f The fiber to add to the sleep queue. The context field must already hold the fiber's wake up time.
+  */
+void queue_sleeping_fiber(Fiber *f);
+
 /**
   * Utility function to the given fiber from whichever queue it is currently stored on. 
   * @param f the fiber to remove.
@@ -240,7 +649,11 @@ void idle();
   * IDLE task.
   * Only scheduled for execution when the runqueue is empty. Typically calls idle().
   */
-void idle_task();
+void idle_task()
+#if CONFIG_ENABLED(MICROBIT_HOST)
+    __attribute__((force_align_arg_pointer))
+#endif
+;
 
 /**
   * Determines if the processor is executing in interrupt context.
@@ -253,11 +666,19 @@ inline int inInterruptContext()
 
 /**
   * Assembler Context switch routing.
-  * Defined in CortexContextSwitch.s
+  * Defined in CortexContextSwitch.s (or HostContextSwitch.s for host builds).
   */
-extern "C" void swap_context(Cortex_M0_TCB *from, Cortex_M0_TCB *to, uint32_t from_stack, uint32_t to_stack);
-extern "C" void save_context(Cortex_M0_TCB *tcb, uint32_t stack);
-extern "C" void save_register_context(Cortex_M0_TCB *tcb);
+extern "C" void swap_context(Cortex_M0_TCB *from, Cortex_M0_TCB *to, PROCESSOR_WORD_TYPE from_stack, PROCESSOR_WORD_TYPE to_stack);
+extern "C" void save_context(Cortex_M0_TCB *tcb, PROCESSOR_WORD_TYPE stack)
+#if CONFIG_ENABLED(MICROBIT_HOST)
+    __attribute__((returns_twice))
+#endif
+;
+extern "C" void save_register_context(Cortex_M0_TCB *tcb)
+#if CONFIG_ENABLED(MICROBIT_HOST)
+    __attribute__((returns_twice))
+#endif
+;
 extern "C" void restore_register_context(Cortex_M0_TCB *tcb);
 
 /**
@@ -0,0 +1,328 @@
+#ifndef MICROBIT_FIBER_SYNC_H
+#define MICROBIT_FIBER_SYNC_H
+
+#include "mbed.h"
+#include "ErrorNo.h"
+#include "MicroBitFiber.h"
+
+/**
+  * Class definition for a FiberMutex.
+  *
+  * A mutual exclusion lock for fibers. Fibers that cannot acquire the lock are parked on the mutex's
+  * own wait queue, and ownership is handed directly to the next waiting fiber when the lock is released.
+  * No MicroBitEvents are generated.
+  *
+  * n.b. synchronisation primitives must only be used from fiber context, never from interrupt context.
+  */
+class FiberMutex
+{
+    Fiber       *owner;         // The fiber currently holding the lock, or NULL if it is free.
+    Fiber       *waitQueue;     // Fibers blocked waiting for the lock.
+
+    public:
+
+    /**
+      * Constructor.
+      * Creates a new, unlocked mutex.
+      */
+    FiberMutex();
+
+    /**
+      * Acquires the lock, blocking the calling fiber until it is available.
+      * If called from a handler run by invoke(), the handler is first forked onto its own fiber, so that the lock
+      * is held by the fiber that will go on to release it.
+      *
+      * Example:
+      * @code
+      * FiberMutex m;
+      *
+      * m.lock();
+      * //do something that must not be interleaved with other fibers
+      * m.unlock();
+      * @endcode
+      */
+    void lock();
+
+    /**
+      * Attempts to acquire the lock, without blocking.
+      * If called from a handler run by invoke(), the handler is first forked onto its own fiber, as lock() does.
+      * @return MICROBIT_OK if the lock was acquired, or MICROBIT_BUSY if it is held by another fiber.
+      */
+    int tryLock();
+
+    /**
+      * Releases the lock. If any fibers are waiting, ownership passes directly to the first of them.
+      * @return MICROBIT_OK on success, or MICROBIT_NOT_SUPPORTED if the lock is not held by the calling fiber.
+      */
+    int unlock();
+
+    /**
+      * Determines if the lock is currently held.
+      * @return 1 if the lock is held, 0 otherwise.
+      */
+    int isLocked();
+};
+
+/**
+  * Class definition for a FiberSemaphore.
+  *
+  * A counting semaphore for fibers. Fibers that wait on an exhausted semaphore are parked on its own
+  * wait queue, and each signal hands a permit directly to the first waiting fiber.
+  * No MicroBitEvents are generated.
+  *
+  * n.b. synchronisation primitives must only be used from fiber context, never from interrupt context.
+  */
+class FiberSemaphore
+{
+    int         count;          // The number of permits currently available.
+    Fiber       *waitQueue;     // Fibers blocked waiting for a permit.
+
+    public:
+
+    /**
+      * Constructor.
+      * @param initial The number of permits initially available (defaults to 0).
+      */
+    FiberSemaphore(int initial = 0);
+
+    /**
+      * Takes a permit, blocking the calling fiber until one is available.
+      *
+      * Example:
+      * @code
+      * FiberSemaphore s;
+      *
+      * s.wait();       // blocks until another fiber calls s.signal()
+      * @endcode
+      */
+    void wait();
+
+    /**
+      * Attempts to take a permit, without blocking.
+      * @return MICROBIT_OK if a permit was taken, or MICROBIT_BUSY if none are available.
+      */
+    int tryWait();
+
+    /**
+      * Releases a permit. If any fibers are waiting, the permit passes directly to the first of them.
+      */
+    void signal();
+
+    /**
+      * Determines the number of permits currently available.
+      * @return The number of permits available.
+      */
+    int getCount();
+};
+
+/**
+  * Class definition for a FiberConditionVariable.
+  *
+  * Allows fibers to block until a condition protected by a FiberMutex is signalled by another fiber.
+  * Fibers are parked on the condition variable's own wait queue. No MicroBitEvents are generated.
+  *
+  * n.b. synchronisation primitives must only be used from fiber context, never from interrupt context.
+  */
+class FiberConditionVariable
+{
+    Fiber       *waitQueue;     // Fibers blocked waiting for the condition to be signalled.
+
+    public:
+
+    /**
+      * Constructor.
+      */
+    FiberConditionVariable();
+
+    /**
+      * Atomically releases the given mutex and blocks the calling fiber until the condition is notified.
+      * The mutex is reacquired before this call returns.
+      *
+      * @param m The mutex protecting the condition, which must be held by the calling fiber.
+      *
+      * Example:
+      * @code
+      * m.lock();
+      * while (!ready)
+      *     cv.wait(m);
+      * m.unlock();
+      * @endcode
+      */
+    void wait(FiberMutex &m);
+
+    /**
+      * Wakes the first fiber waiting on this condition, if any.
+      */
+    void notifyOne();
+
+    /**
+      * Wakes every fiber waiting on this condition.
+      */
+    void notifyAll();
+};
+
+/**
+  * Class definition for a FiberHandle.
+  *
+  * A reference to a fiber that remains safe to use after the fiber has completed and been recycled
+  * through the fiber pool. Handles are small, copyable values, and joining never allocates memory.
+  */
+class FiberHandle
+{
+    Fiber       *fiber;         // The fiber this handle refers to.
+    uint32_t    generation;     // The generation of the fiber when this handle was created.
+
+    public:
+
+    /**
+      * Constructor.
+      * Creates a handle that refers to no fiber. Joining such a handle returns immediately.
+      */
+    FiberHandle();
+
+    /**
+      * Constructor.
+      * Creates a handle to the given fiber, as returned by create_fiber().
+      *
+      * @param f The fiber to refer to.
+      *
+      * Example:
+      * @code
+      * FiberHandle h = create_fiber(readSensors);
+      * @endcode
+      */
+    FiberHandle(Fiber *f);
+
+    /**
+      * Blocks the calling fiber until the referenced fiber completes.
+      * Returns immediately if it has already completed.
+      *
+      * @return MICROBIT_OK once the fiber has completed, or MICROBIT_INVALID_PARAMETER if the calling fiber attempts to join itself.
+      *
+      * Example:
+      * @code
+      * FiberHandle a = create_fiber(readAccelerometer);
+      * FiberHandle c = create_fiber(readCompass);
+      *
+      * a.join();
+      * c.join();
+      * @endcode
+      */
+    int join();
+
+    /**
+      * Determines if the referenced fiber is still running.
+      * @return 1 if the fiber has yet to complete, 0 otherwise.
+      */
+    int isRunning();
+};
+
+/**
+  * Class definition for a FiberFuture.
+  *
+  * Holds a single value that is produced by one fiber and consumed by others. Fibers that ask for the
+  * value before it has been set are parked on the future's own wait queue until it is set.
+  *
+  * n.b. synchronisation primitives must only be used from fiber context, never from interrupt context.
+  */
+template <typename T>
+class FiberFuture
+{
+    T           value;          // The value, once set.
+    int         ready;          // Non-zero once the value has been set.
+    Fiber       *waitQueue;     // Fibers blocked waiting for the value.
+
+    public:
+
+    /**
+      * Constructor.
+      * Creates a future whose value has yet to be set.
+      */
+    FiberFuture();
+
+    /**
+      * Sets the value of this future, and wakes any fibers waiting for it.
+      * @param v The value.
+      * @return MICROBIT_OK on success, or MICROBIT_NOT_SUPPORTED if the value has already been set.
+      */
+    int set(T v);
+
+    /**
+      * Retrieves the value of this future, blocking the calling fiber until it has been set.
+      * @return The value.
+      *
+      * Example:
+      * @code
+      * FiberFuture<int> heading;
+      *
+      * void readCompass(void *f)
+      * {
+      *     ((FiberFuture<int> *) f)->set(uBit.compass.heading());
+      * }
+      *
+      * create_fiber(readCompass, &heading);
+      * uBit.display.scroll(heading.get());
+      * @endcode
+      */
+    T get();
+
+    /**
+      * Determines if the value of this future has been set.
+      * @return 1 if the value has been set, 0 otherwise.
+      */
+    int isReady();
+};
+
+/**
+  * Constructor.
+  * Creates a future whose value has yet to be set.
+  */
+template <typename T>
+FiberFuture<T>::FiberFuture()
+{
+    ready = 0;
+    waitQueue = NULL;
+}
+
+/**
+  * Sets the value of this future, and wakes any fibers waiting for it.
+  * @param v The value.
+  * @return MICROBIT_OK on success, or MICROBIT_NOT_SUPPORTED if the value has already been set.
+  */
+template <typename T>
+int FiberFuture<T>::set(T v)
+{
+    if (ready)
+        return MICROBIT_NOT_SUPPORTED;
+
+    value = v;
+    ready = 1;
+    fiber_wake_all(&waitQueue);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Retrieves the value of this future, blocking the calling fiber until it has been set.
+  * @return The value.
+  */
+template <typename T>
+T FiberFuture<T>::get()
+{
+    if (!ready)
+        fiber_wait_on(&waitQueue);
+
+    return value;
+}
+
+/**
+  * Determines if the value of this future has been set.
+  * @return 1 if the value has been set, 0 otherwise.
+  */
+template <typename T>
+int FiberFuture<T>::isReady()
+{
+    return ready;
+}
+
+#endif
@@ -0,0 +1,115 @@
+/**
+  * Definitions for the host backend of the micro:bit runtime.
+  *
+  * Allows the fiber scheduler and message bus to be built and run natively on an x86-64 Linux host,
+  * for example to measure scheduler throughput and latency without a board. This header provides host
+  * equivalents of the Cortex M0 specific intrinsics used by the runtime, and is force included ahead of
+  * every source file in a host build (see source/CMakeLists.txt).
+  *
+  * Saved fiber contexts hold 64 bit registers on the host (see PROCESSOR_WORD_TYPE). Processor interrupts are modelled with signals: the periodic system tick is delivered as SIGALRM,
+  * and __disable_irq() / __enable_irq() mask and unmask it.
+  */
+
+#ifndef MICROBIT_HOST_H
+#define MICROBIT_HOST_H
+
+#include <stdint.h>
+
+#if !defined(__x86_64__)
+#error "The micro:bit host backend requires an x86-64 build"
+#endif
+
+#define MICROBIT_HOST                       1
+
+// Fiber contexts hold 64 bit registers and addresses on the host.
+#define PROCESSOR_WORD_TYPE                 uintptr_t
+
+// Size of the region of memory used as the system stack by fibers (bytes).
+#ifndef MICROBIT_HOST_STACK_SIZE
+#define MICROBIT_HOST_STACK_SIZE            65536
+#endif
+
+// Size of the stack used to handle simulated interrupts (bytes).
+#ifndef MICROBIT_HOST_SIGNAL_STACK_SIZE
+#define MICROBIT_HOST_SIGNAL_STACK_SIZE     65536
+#endif
+
+// Additional stack captured above the entry point of a fiber that forks on block (bytes).
+// Unlike the Cortex M0 build, the host compiler may spill the locals of invoke() into its own stack frame, which
+// lies above the entry point. This ensures they are preserved by the forked fiber.
+#define MICROBIT_HOST_FORK_STACK_MARGIN     64
+
+extern uint32_t microbit_host_stack[];
+
+// The system stack is a static buffer, rather than a fixed physical address.
+#define CORTEX_M0_STACK_BASE                ((uintptr_t) &microbit_host_stack[MICROBIT_HOST_STACK_SIZE / 4])
+
+/**
+  * Disables simulated interrupts.
+  */
+void __disable_irq();
+
+/**
+  * Enables simulated interrupts. Has no effect when called from a simulated interrupt handler.
+  */
+void __enable_irq();
+
+/**
+  * Determines the current value of the stack pointer.
+  * @return The current stack pointer.
+  */
+inline uintptr_t __get_MSP()
+{
+    uintptr_t sp;
+
+    __asm__ volatile ("movq %%rsp, %0" : "=r" (sp));
+
+    return sp;
+}
+
+/**
+  * Determines the exception currently being serviced.
+  * @return 15 (SysTick) when called from a simulated interrupt handler, and 0 otherwise.
+  */
+uint32_t __get_IPSR();
+
+/**
+  * Waits for a simulated interrupt.
+  */
+void __WFI();
+
+/**
+  * Reads the host's microsecond clock.
+  * @return The time since an arbitrary epoch in microseconds, modulo 2^32.
+  */
+uint32_t us_ticker_read();
+
+/**
+  * Configures a simulated periodic interrupt, typically used to drive the scheduler via scheduler_tick().
+  * There is a single simulated timer, so this replaces any interrupt configured previously.
+  *
+  * @param handler The function to call from simulated interrupt context.
+  * @param period_us The period of the interrupt, in microseconds, or 0 for a single interrupt.
+  * @param delay_us The time until the first interrupt, in microseconds, or 0 to wait for a whole period.
+  *
+  * Example:
+  * @code
+  * microbit_host_attach_tick(scheduler_tick, FIBER_TICK_PERIOD_MS * 1000);
+  * @endcode
+  */
+void microbit_host_attach_tick(void (*handler)(void), uint32_t period_us, uint32_t delay_us = 0);
+
+/**
+  * The number of simulated interrupts handled so far.
+  */
+extern volatile uint32_t microbit_host_irq_count;
+
+/**
+  * Switches onto the simulated system stack, and calls the given function.
+  * This must be used to run any code that uses the fiber scheduler. The process exits once the function returns.
+  *
+  * @param entry The function to run, typically one that calls scheduler_init() and then the code under test.
+  */
+void microbit_host_start(void (*entry)(void));
+
+#endif
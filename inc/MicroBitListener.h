@@ -1,10 +1,14 @@
 #ifndef MICROBIT_LISTENER_H
 #define MICROBIT_LISTENER_H
 
+#include <new>
 #include "mbed.h"
+#include "MicroBitConfig.h"
 #include "MicroBitEvent.h"
 #include "MemberFunctionCallback.h"
 
+struct Fiber;
+
 // MicroBitListener flags...
 #define MESSAGE_BUS_LISTENER_PARAMETERISED          0x0001
 #define MESSAGE_BUS_LISTENER_METHOD                 0x0002
@@ -14,28 +18,74 @@
 #define MESSAGE_BUS_LISTENER_DROP_IF_BUSY           0x0020
 #define MESSAGE_BUS_LISTENER_NONBLOCKING            0x0040
 #define MESSAGE_BUS_LISTENER_URGENT                 0x0080
+#define MESSAGE_BUS_LISTENER_DEDICATED_FIBER        0x0100      // Always run on a fiber created when the listener is registered, rather than forking on block.
+#define MESSAGE_BUS_LISTENER_COALESCE               0x0200      // Replace any queued event with the same ID and value, rather than queueing another.
+#define MESSAGE_BUS_LISTENER_BATCH                  0x0400      // Deliver all pending events in a single call, once the event queue has been drained.
+#define MESSAGE_BUS_LISTENER_THROTTLE               0x0800      // Deliver at most one event per interval. The newest event to arrive in the meantime is delivered at the end of the interval.
+#define MESSAGE_BUS_LISTENER_DEBOUNCE               0x1000      // Deliver only the newest event, once no more have arrived for an interval.
+#define MESSAGE_BUS_LISTENER_DEFERRED               0x2000      // An event is being held for later delivery (MESSAGE_BUS_LISTENER_THROTTLE and MESSAGE_BUS_LISTENER_DEBOUNCE only).
 #define MESSAGE_BUS_LISTENER_DELETING               0x8000
 
 #define MESSAGE_BUS_LISTENER_IMMEDIATE              (MESSAGE_BUS_LISTENER_NONBLOCKING |  MESSAGE_BUS_LISTENER_URGENT)
 
+// Listeners registered with any of these options need a MicroBitListenerState.
+#define MESSAGE_BUS_LISTENER_STATEFUL               (MESSAGE_BUS_LISTENER_BATCH | MESSAGE_BUS_LISTENER_THROTTLE | MESSAGE_BUS_LISTENER_DEBOUNCE | MESSAGE_BUS_LISTENER_DEDICATED_FIBER)
+
+/**
+  * State needed only by listeners registered with MESSAGE_BUS_LISTENER_STATEFUL options.
+  * This is allocated separately when such a listener is registered, so that other listeners don't pay for it.
+  */
+struct MicroBitListenerState
+{
+    MicroBitEvent   *batch;         // Events waiting to be delivered in a single call (MESSAGE_BUS_LISTENER_BATCH only).
+    uint16_t        batch_length;   // The number of events in the batch.
+
+    MicroBitEvent   deferred_evt;   // The event held for later delivery (MESSAGE_BUS_LISTENER_DEFERRED only).
+    uint32_t        deadline;       // The time (ms) before which no event may be delivered when throttled, or at which the held event is due when debounced.
+
+    Fiber           *fiber;         // The fiber dedicated to this listener, whilst it waits for an event (MESSAGE_BUS_LISTENER_DEDICATED_FIBER only).
+
+    /**
+      * Constructor.
+      * @param batched Allocate a buffer to hold a batch of events, if non-zero.
+      */
+    MicroBitListenerState(int batched);
+
+    /**
+      * Destructor. Frees the batch buffer, if any.
+      */
+    ~MicroBitListenerState();
+};
+
 
 struct MicroBitListener
 {
 	uint16_t		id;				// The ID of the component that this listener is interested in. 
 	uint16_t 		value;			// Value this listener is interested in receiving. 
     uint16_t        flags;          // Status and configuration options codes for this listener.
+    uint16_t        interval;       // The throttle or debounce interval (ms).
 
     union 
     {
         void (*cb)(MicroBitEvent);
         void (*cb_param)(MicroBitEvent, void *);
-        MemberFunctionCallback *cb_method;
+        void (*cb_batch)(MicroBitEvent *, int, void *);
+        uint32_t cb_method_storage[(sizeof(MemberFunctionCallback) + 3) / 4];    // Holds the MemberFunctionCallback of a method listener, so it needs no allocation of its own.
     };
 
+    MemberFunctionCallback *cb_method;  // The method to call (MESSAGE_BUS_LISTENER_METHOD only). Points to cb_method_storage.
+
 	void*			cb_arg;			// Optional argument to be passed to the caller. 
 
 	MicroBitEvent 	            evt;
 	MicroBitEventQueueItem 	    *evt_queue;
+
+    MicroBitListenerState *state;   // Mode specific state, or NULL if no MESSAGE_BUS_LISTENER_STATEFUL options are given.
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    uint32_t        inline_count;   // The number of events this listener handled without blocking.
+    uint32_t        fork_count;     // The number of events this listener blocked on, and so were forked onto a new fiber.
+#endif
 	
 	MicroBitListener *next;
 
@@ -54,6 +104,12 @@ struct MicroBitListener
 	  */
     MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent, void *), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
+	/**
+	  * Alternative constructor for a listener that receives events in batches.
+	  * The buffer to hold the batch is allocated with the rest of its state, when the listener is registered.
+	  */
+    MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent *, int, void *), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+
     /**
      * Constructor. 
      * Create a new Message Bus Listener, with a callback to a c++ member function.
@@ -70,6 +126,20 @@ struct MicroBitListener
       */
     ~MicroBitListener();
 
+#if MESSAGE_BUS_LISTENER_POOL_CHUNK > 0
+    /**
+      * Allocates memory for a listener from the pool of listeners.
+      * The pool is refilled from the heap MESSAGE_BUS_LISTENER_POOL_CHUNK listeners at a time.
+      * @return The memory, or NULL if the pool is empty and the heap exhausted.
+      */
+    static void *operator new(size_t size) throw();
+
+    /**
+      * Returns the memory used by a listener to the pool of listeners.
+      */
+    static void operator delete(void *p);
+#endif
+
     /**
      * Queues and event up to be processed.
      * @param e The event to queue
@@ -91,10 +161,18 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, T* object, void
 {
 	this->id = id;
 	this->value = value;
-    this->cb_method = new MemberFunctionCallback(object, method);
+    this->cb_method = new (this->cb_method_storage) MemberFunctionCallback(object, method);
 	this->cb_arg = NULL;
     this->flags = flags | MESSAGE_BUS_LISTENER_METHOD;
 	this->next = NULL;
+    this->evt_queue = NULL;
+    this->interval = 0;
+    this->state = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    this->inline_count = 0;
+    this->fork_count = 0;
+#endif
 }
 
 #endif
@@ -11,6 +11,63 @@
 #define MICROBIT_ID_ANY					0
 #define MICROBIT_EVT_ANY				0
 
+// Message bus events
+#define MICROBIT_MESSAGE_BUS_EVT_DROPPED    1   // Raised once events have been dropped because the event queue was full.
+
+// Event policy flags, as used by setEventPolicy()
+#define MESSAGE_BUS_EVENT_COALESCE      0x01    // A queued event replaces any event with the same ID and value still waiting to be processed.
+#define MESSAGE_BUS_EVENT_LANE(n)       ((n) << 4)          // Events are queued on priority lane n (see MESSAGE_BUS_PRIORITY_LANES).
+#define MESSAGE_BUS_EVENT_GET_LANE(f)   (((f) >> 4) & 0x0F)
+
+// Priority lanes of the event queue.
+#define MESSAGE_BUS_LANE_LOWEST         0
+#define MESSAGE_BUS_LANE_HIGHEST        (MESSAGE_BUS_PRIORITY_LANES - 1)
+
+/**
+  * The policy applied by the MicroBitMessageBus to events with a given ID and value.
+  */
+struct MicroBitEventPolicy
+{
+    uint16_t id;                        // The ID of the events this policy applies to.
+    uint16_t value;                     // The VALUE of the events this policy applies to, or MICROBIT_EVT_ANY.
+    uint16_t flags;                     // The policy to apply, or 0 if this entry is unused.
+};
+
+// Event trace record types
+#define MESSAGE_BUS_TRACE_SEND              1   // The event was sent to the message bus.
+#define MESSAGE_BUS_TRACE_PROCESS           2   // The event was delivered to its standard listeners.
+#define MESSAGE_BUS_TRACE_PROCESS_URGENT    3   // The event was delivered to its urgent listeners.
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+/**
+  * A single record in the MicroBitMessageBus event trace.
+  * This is also the layout of each record sent by MicroBitSerial::sendEventTrace() (little endian).
+  */
+struct MicroBitEventTraceRecord
+{
+    uint32_t timestamp;                 // The time at which the record was started (us, as given by us_ticker_read()).
+    uint16_t source;                    // The ID of the event.
+    uint16_t value;                     // The VALUE of the event.
+    uint16_t duration;                  // The time taken to deliver the event (us, saturating at 65535). Zero for MESSAGE_BUS_TRACE_SEND.
+    uint8_t listeners;                  // The number of listeners the event was delivered to (saturating at 255).
+    uint8_t type;                       // The type of the record (MESSAGE_BUS_TRACE_*).
+};
+#endif
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+/**
+  * Statistics on the use of the MicroBitMessageBus event queue.
+  */
+struct MicroBitMessageBusStatistics
+{
+    uint32_t enqueued;                  // The number of events added to the queue.
+    uint32_t dropped;                   // The number of events dropped because the queue was full.
+    uint32_t coalesced;                 // The number of events merged with one already in the queue.
+    uint32_t max_depth;                 // The largest number of events held in the queue at once.
+    uint32_t residency[MESSAGE_BUS_RESIDENCY_BUCKETS];  // Histogram of the time events spent in the queue. See MESSAGE_BUS_RESIDENCY_BUCKETS.
+};
+#endif
+
 /**
   * Class definition for the MicroBitMessageBus.
   *
@@ -56,6 +113,16 @@ class MicroBitMessageBus : public MicroBitComponent
 	  */
 	void send(MicroBitEvent evt);
 
+	/**
+	  * Queues the given event to be sent to all registered recipients, on the given priority lane.
+	  * Queued events are processed highest lane first, and in the order they were sent within each lane.
+	  * By default, events are queued on the lane given by their policy (see setEventPolicy()), or MESSAGE_BUS_LANE_LOWEST.
+	  *
+	  * @param evt The event to send.
+	  * @param lane The priority lane to queue the event on, between MESSAGE_BUS_LANE_LOWEST and MESSAGE_BUS_LANE_HIGHEST.
+	  */
+	void send(MicroBitEvent evt, int lane);
+
 	/**
       * Internal function, used to deliver the given event to all relevant recipients.
       * Normally, this is called once an event has been removed from the event queue.
@@ -80,6 +147,11 @@ class MicroBitMessageBus : public MicroBitComponent
 	  * Use MICROBIT_EVT_ANY to receive events of any value.
 	  *
 	  * @param handler The function to call when an event is received.
+	  *
+	  * @param flags The MESSAGE_BUS_LISTENER_* options for the listener (optional).
+	  *
+	  * @param interval The throttle or debounce interval in milliseconds, if MESSAGE_BUS_LISTENER_THROTTLE or
+	  * MESSAGE_BUS_LISTENER_DEBOUNCE is given in flags (optional).
       *
       * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
 	  *
@@ -90,9 +162,12 @@ class MicroBitMessageBus : public MicroBitComponent
       * 	//do something
       * }
       * uBit.MessageBus.listen(MICROBIT_ID_BUTTON_B, MICROBIT_BUTTON_EVT_CLICK, onButtonBClick); // call function when ever a click event is detected.
+      *
+      * // Show the latest compass heading at most five times a second.
+      * uBit.MessageBus.listen(MICROBIT_ID_COMPASS, MICROBIT_COMPASS_EVT_DATA_UPDATE, onHeading, MESSAGE_BUS_LISTENER_DEFAULT_FLAGS | MESSAGE_BUS_LISTENER_THROTTLE, 200);
       * @endcode
 	  */
-	int listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS, uint16_t interval = 0);
 
 	/**
 	  * Register a listener function.
@@ -104,6 +179,13 @@ class MicroBitMessageBus : public MicroBitComponent
 	  * Use MICROBIT_EVT_ANY to receive events of any value.
 	  *
 	  * @param hander The function to call when an event is received.
+	  *
+	  * @param arg An additional argument to pass to the handler.
+	  *
+	  * @param flags The MESSAGE_BUS_LISTENER_* options for the listener (optional).
+	  *
+	  * @param interval The throttle or debounce interval in milliseconds, if MESSAGE_BUS_LISTENER_THROTTLE or
+	  * MESSAGE_BUS_LISTENER_DEBOUNCE is given in flags (optional).
       *
       * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
 	  *
@@ -116,7 +198,7 @@ class MicroBitMessageBus : public MicroBitComponent
       * uBit.MessageBus.listen(MICROBIT_ID_BUTTON_B, MICROBIT_BUTTON_EVT_CLICK, onButtonBClick); // call function when ever a click event is detected.
       * @endcode
 	  */
-	int listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS, uint16_t interval = 0);
 
 	/**
 	  * Register a listener function.
@@ -128,6 +210,11 @@ class MicroBitMessageBus : public MicroBitComponent
 	  * Use MICROBIT_EVT_ANY to receive events of any value.
 	  *
 	  * @param hander The function to call when an event is received.
+	  *
+	  * @param flags The MESSAGE_BUS_LISTENER_* options for the listener (optional).
+	  *
+	  * @param interval The throttle or debounce interval in milliseconds, if MESSAGE_BUS_LISTENER_THROTTLE or
+	  * MESSAGE_BUS_LISTENER_DEBOUNCE is given in flags (optional).
       *
       * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
 	  *
@@ -143,7 +230,35 @@ class MicroBitMessageBus : public MicroBitComponent
       * @endcode
 	  */
     template <typename T>
-	int listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
+	int listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS, uint16_t interval = 0);
+
+	/**
+	  * Register a listener function that receives events in batches.
+	  * Matching events are gathered as the event queue is processed, and delivered in a single call once the
+	  * queue has been drained (or up to MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH have been gathered). This allows
+	  * handlers of high rate events to amortise the cost of each call.
+	  *
+	  * @param id The source of messages to listen for. Events sent from any other IDs will be filtered.
+	  * Use MICROBIT_ID_ANY to receive events from all components.
+	  *
+	  * @param value The value of messages to listen for. Events with any other values will be filtered.
+	  * Use MICROBIT_EVT_ANY to receive events of any value.
+	  *
+	  * @param handler The function to call with the events received, oldest first.
+	  * @param arg An additional argument to pass to the handler.
+	  *
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER or MICROBIT_NO_RESOURCES.
+	  *
+      * Example:
+      * @code
+      * void onAccelerometerData(MicroBitEvent *events, int count, void *arg)
+      * {
+      * 	//do something with all the events at once
+      * }
+      * uBit.MessageBus.listen(MICROBIT_ID_ACCELEROMETER, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, onAccelerometerData, NULL);
+      * @endcode
+	  */
+	int listen(int id, int value, void (*handler)(MicroBitEvent *, int, void *), void* arg, uint16_t flags = MESSAGE_BUS_LISTENER_DEFAULT_FLAGS);
 
 
 	/**
@@ -216,6 +331,94 @@ class MicroBitMessageBus : public MicroBitComponent
     template <typename T>
 	int ignore(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent));
 
+	/**
+	  * Unregister a listener function that receives events in batches.
+      * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+	  *
+	  * @param id The Event ID used to register the listener.
+	  * @param value The Event VALUE used to register the listener.
+	  * @param handler The function used to register the listener.
+      *
+      * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
+	  */
+	int ignore(int id, int value, void (*handler)(MicroBitEvent *, int, void *));
+
+    /**
+      * Sets the policy applied to events with the given ID and value when they are queued.
+      *
+      * @param id The ID of the events to apply the policy to.
+      * @param value The VALUE of the events to apply the policy to. Use MICROBIT_EVT_ANY to apply it to events of any value.
+      * @param flags The policy to apply (e.g. MESSAGE_BUS_EVENT_COALESCE | MESSAGE_BUS_EVENT_LANE(1)), or 0 to remove any existing policy.
+      * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if MESSAGE_BUS_EVENT_POLICIES are already in use.
+      *
+      * Example:
+      * @code
+      * // Only deliver the latest accelerometer update, however slowly the handlers keep up.
+      * uBit.MessageBus.setEventPolicy(MICROBIT_ID_ACCELEROMETER, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, MESSAGE_BUS_EVENT_COALESCE);
+      * @endcode
+      */
+    int setEventPolicy(uint16_t id, uint16_t value, uint16_t flags);
+
+    /**
+      * Determines the policy applied to events with the given ID and value when they are queued.
+      *
+      * @param id The ID of the event.
+      * @param value The VALUE of the event.
+      * @return The policy flags for the event, or 0 if no policy has been set.
+      */
+    int getEventPolicy(uint16_t id, uint16_t value);
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+    /**
+      * Provides statistics on the use of the event queue, gathered since power on or the last call to resetStatistics().
+      *
+      * Example:
+      * @code
+      * void onDropped(MicroBitEvent)
+      * {
+      *     uBit.serial.printf("dropped: %d\r\n", uBit.MessageBus.getStatistics()->dropped);
+      * }
+      *
+      * uBit.MessageBus.listen(MICROBIT_ID_MESSAGE_BUS, MICROBIT_MESSAGE_BUS_EVT_DROPPED, onDropped);
+      * @endcode
+      *
+      * @return The event queue statistics.
+      */
+    const MicroBitMessageBusStatistics *getStatistics();
+
+    /**
+      * Clears the event queue statistics.
+      */
+    void resetStatistics();
+#endif
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    /**
+      * Determines how many trace records have been made since power on.
+      * Only the most recent MESSAGE_BUS_TRACE_DEPTH of these are held.
+      *
+      * @return The number of trace records made.
+      */
+    uint32_t getTraceCount();
+
+    /**
+      * Retrieves a record from the event trace.
+      *
+      * @param n The index of the record, where 0 is the oldest record held.
+      * @return The trace record, or NULL if n is out of range.
+      */
+    const MicroBitEventTraceRecord *getTraceRecord(int n);
+
+    /**
+      * Suspends or resumes recording of the event trace, so that it can be read without changing underneath
+      * the reader. Anything that would have been recorded whilst the trace is suspended is discarded.
+      *
+      * @param suspended 1 to suspend recording, 0 to resume it.
+      * @return 1 if recording was suspended before this call, 0 otherwise.
+      */
+    int suspendTrace(int suspended);
+#endif
+
     /**
       * Returns the microBitListener with the given position in our list.
       * @param n The position in the list to return.
@@ -250,17 +453,80 @@ class MicroBitMessageBus : public MicroBitComponent
      */
     int deleteMarkedListeners();
 
-	MicroBitListener            *listeners;		    // Chain of active listeners.
-    MicroBitEventQueueItem      *evt_queue_head;    // Head of queued events to be processed.
-    MicroBitEventQueueItem      *evt_queue_tail;    // Tail of queued events to be processed.
+    /**
+     * Delivers the given event to the matching event handlers on the given chain of listeners.
+     * @param l The first listener in the chain.
+     * @param evt The event to be delivered.
+     * @param urgent The type of listeners to process. See process().
+     * @return 1 if all matching listeners were processed, 0 if further processing is required.
+     */
+    int processListeners(MicroBitListener *l, MicroBitEvent &evt, bool urgent);
+
+    /**
+     * Hands the given event to the event handler of the given listener.
+     * @param l The listener.
+     * @param evt The event to be delivered.
+     */
+    void deliver(MicroBitListener *l, MicroBitEvent &evt);
+
+    /**
+     * Determines whether a throttled or debounced listener should receive the given event now, or later.
+     * @param l The listener.
+     * @param evt The event to be delivered.
+     * @return 1 if the event is being held for later delivery, 0 if it should be delivered now.
+     */
+    int deferEvent(MicroBitListener *l, MicroBitEvent &evt);
+
+    /**
+     * Delivers the events held by throttled and debounced listeners that are now due.
+     */
+    void flushDeferred();
+
+    /**
+     * Delivers the events gathered by every listener that receives events in batches.
+     */
+    void flushBatches();
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    /**
+     * Adds a record to the event trace.
+     * @param type The type of record (MESSAGE_BUS_TRACE_*).
+     * @param evt The event.
+     * @param start The time at which the operation started (us).
+     * @param listeners The number of listeners the event was delivered to.
+     */
+    void trace(uint8_t type, MicroBitEvent &evt, uint32_t start, int listeners);
+#endif
+
+	MicroBitListener            *listeners[MESSAGE_BUS_LISTENER_BUCKETS + 1];   // Chains of active listeners, indexed by ID. The first holds listeners for MICROBIT_ID_ANY.
+    MicroBitEvent               evt_queue[MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH];  // Ring buffer of events waiting to be processed.
+    uint16_t                    evt_queue_head;     // The index of the oldest event in evt_queue.
     uint16_t                    nonce_val;          // The last nonce issued.
     uint16_t                    queueLength;        // The number of events currently waiting to be processed.
+    uint16_t                    batchPending;       // Non-zero if any listener has a batch of events waiting to be delivered.
+    uint32_t                    deferredDeadline;   // The earliest time at which an event held by a throttled or debounced listener is due, or MICROBIT_SYSTEM_TICK_NONE.
+    uint8_t                     laneLength[MESSAGE_BUS_PRIORITY_LANES];     // The number of events waiting on each priority lane.
+    uint16_t                    laneDequeued[MESSAGE_BUS_PRIORITY_LANES];   // The number of events ever removed from each priority lane.
+    MicroBitEventPolicy         policies[MESSAGE_BUS_EVENT_POLICIES];   // Policies applied to specific events when queued.
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    MicroBitEventTraceRecord    traceRecords[MESSAGE_BUS_TRACE_DEPTH];   // Ring buffer of the most recent trace records.
+    uint32_t                    traceCount;         // The number of trace records made since power on.
+    uint16_t                    traceDispatched;    // The number of listeners the event currently being processed has been delivered to.
+    uint8_t                     traceSuspended;     // Non-zero whilst recording of the trace is suspended.
+#endif
 
-    void queueEvent(MicroBitEvent &evt);
-    MicroBitEventQueueItem* dequeueEvent();
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+    MicroBitMessageBusStatistics statistics;        // Event queue statistics.
+    uint32_t                    droppedReported;    // The value of statistics.dropped when a MICROBIT_MESSAGE_BUS_EVT_DROPPED event was last raised.
+#endif
+
+    void queueEvent(MicroBitEvent &evt, int lane);
+    int dequeueEvent(MicroBitEvent &evt);
 
     virtual void idleTick();
     virtual int isIdleCallbackNeeded();
+    virtual unsigned long nextSystemTick();
 };
 
 /**
@@ -275,17 +541,24 @@ class MicroBitMessageBus : public MicroBitComponent
   *
   * @param object The object on which the method should be invoked.
   * @param handler The method to call when an event is received.
+  * @param flags The MESSAGE_BUS_LISTENER_* options for the listener.
+  * @param interval The throttle or debounce interval in milliseconds, if MESSAGE_BUS_LISTENER_THROTTLE or MESSAGE_BUS_LISTENER_DEBOUNCE is given in flags.
   *
   * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
   */
 template <typename T>
-int MicroBitMessageBus::listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags)
+int MicroBitMessageBus::listen(uint16_t id, uint16_t value, T* object, void (T::*handler)(MicroBitEvent), uint16_t flags, uint16_t interval)
 {
 	if (object == NULL || handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
 	MicroBitListener *newListener = new MicroBitListener(id, value, object, handler, flags);
 
+    if (newListener == NULL)
+        return MICROBIT_NO_RESOURCES;
+
+    newListener->interval = interval;
+
     if(add(newListener) == MICROBIT_OK)
         return MICROBIT_OK;
 
@@ -2,6 +2,7 @@
 #define MICROBIT_SERIAL_H
 
 #include "mbed.h"
+#include "MicroBitConfig.h"
 #include "ManagedString.h"
 #include "MicroBitImage.h"
 
@@ -111,6 +112,23 @@ class MicroBitSerial : public Serial
       * @endcode
       */
     void readDisplayState();
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    /**
+      * Sends the message bus event trace over serial, in binary.
+      *
+      * The trace starts with an 8 byte header: the characters "MBTR", a format version (1), the size of each
+      * record in bytes, and the number of records that follow (16 bit little endian). Each record is then sent
+      * oldest first, in the layout of MicroBitEventTraceRecord. Use utils/decode_event_trace.py to print it as a timeline.
+      * Recording of the trace is suspended whilst it is sent.
+      *
+      * Example:
+      * @code 
+      * uBit.serial.sendEventTrace();
+      * @endcode
+      */
+    void sendEventTrace();
+#endif
     
 };
 
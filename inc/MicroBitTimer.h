@@ -0,0 +1,191 @@
+#ifndef MICROBIT_TIMER_H
+#define MICROBIT_TIMER_H
+
+#include "mbed.h"
+#include "MicroBitConfig.h"
+#include "MicroBitComponent.h"
+
+/**
+  * A single timer, as held by the MicroBitTimer.
+  */
+struct MicroBitTimerEntry
+{
+    unsigned long expiry;               // The system time at which the timer next fires (ms).
+    unsigned long period;               // The time between each firing of a periodic timer (ms), or 0 for a one shot timer.
+    void (*fn)(void *);                 // The function to call when the timer fires, or NULL if the timer raises an event.
+    void *arg;                          // The argument to pass to fn.
+    uint16_t id;                        // The ID of the event to raise when the timer fires (if fn is NULL).
+    uint16_t value;                     // The VALUE of the event to raise when the timer fires (if fn is NULL).
+};
+
+/**
+  * Class definition for MicroBitTimer.
+  *
+  * Provides any number of one shot and periodic timers, without the cost of a fiber (and its stack) for each.
+  * When a timer fires, it either raises an event on the MicroBitMessageBus, or calls a function from the idle
+  * thread (see scheduler_defer()), so handlers must not block.
+  *
+  * Timers are held in a binary min-heap ordered by expiry time, so adding a timer takes O(log n) time, and the
+  * system tick only ever needs to check the timer at the top of the heap.
+  */
+class MicroBitTimer : public MicroBitComponent
+{
+    MicroBitTimerEntry      *timers;        // The heap of active timers. The next to expire is always the first.
+    uint16_t                timerCount;     // The number of active timers.
+    uint16_t                capacity;       // The number of timers there is currently room for.
+
+    public:
+
+    /**
+      * Constructor.
+      * Create a new timer service, and register it for system ticks.
+      * @param id the ID of the new MicroBitTimer object.
+      *
+      * Example:
+      * @code
+      * timer(MICROBIT_ID_TIMER);
+      * @endcode
+      */
+    MicroBitTimer(uint16_t id);
+
+    /**
+      * Raises the given event once, after the given time.
+      *
+      * @param interval The time to wait before raising the event (ms).
+      * @param id The ID of the event to raise.
+      * @param value The VALUE of the event to raise.
+      * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if there is insufficient memory.
+      *
+      * Example:
+      * @code
+      * uBit.timer.eventAfter(500, MICROBIT_ID_TIMER, 1);
+      * @endcode
+      */
+    int eventAfter(unsigned long interval, uint16_t id, uint16_t value);
+
+    /**
+      * Raises the given event periodically, until the timer is cancelled.
+      *
+      * @param period The time between each event (ms).
+      * @param id The ID of the event to raise.
+      * @param value The VALUE of the event to raise.
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if period is 0, or MICROBIT_NO_RESOURCES if
+      * there is insufficient memory.
+      *
+      * Example:
+      * @code
+      * uBit.MessageBus.listen(MICROBIT_ID_TIMER, 2, onTick);
+      * uBit.timer.eventEvery(100, MICROBIT_ID_TIMER, 2);
+      * @endcode
+      */
+    int eventEvery(unsigned long period, uint16_t id, uint16_t value);
+
+    /**
+      * Calls the given function once, after the given time.
+      * The function is called from the idle thread, and must not block.
+      *
+      * @param interval The time to wait before calling the function (ms).
+      * @param fn The function to call.
+      * @param arg The argument to pass to the function.
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL, or MICROBIT_NO_RESOURCES if
+      * there is insufficient memory.
+      */
+    int callAfter(unsigned long interval, void (*fn)(void *), void *arg = NULL);
+
+    /**
+      * Calls the given function periodically, until the timer is cancelled.
+      * The function is called from the idle thread, and must not block.
+      *
+      * @param period The time between each call (ms).
+      * @param fn The function to call.
+      * @param arg The argument to pass to the function.
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL or period is 0, or
+      * MICROBIT_NO_RESOURCES if there is insufficient memory.
+      *
+      * Example:
+      * @code
+      * void blink(void *)
+      * {
+      *     uBit.display.image.setPixelValue(0, 0, !uBit.display.image.getPixelValue(0, 0));
+      * }
+      *
+      * uBit.timer.callEvery(500, blink);
+      * @endcode
+      */
+    int callEvery(unsigned long period, void (*fn)(void *), void *arg = NULL);
+
+    /**
+      * Cancels all timers that raise the given event.
+      *
+      * @param id The ID of the event.
+      * @param value The VALUE of the event.
+      * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if no such timer was found.
+      */
+    int cancel(uint16_t id, uint16_t value);
+
+    /**
+      * Cancels all timers that call the given function with the given argument.
+      *
+      * @param fn The function.
+      * @param arg The argument passed to the function.
+      * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if no such timer was found.
+      */
+    int cancel(void (*fn)(void *), void *arg = NULL);
+
+    /**
+      * Determines the number of active timers.
+      * @return The number of timers that are yet to fire, including all periodic timers.
+      */
+    int getTimerCount();
+
+    /**
+      * Periodic callback from MicroBit system tick.
+      * Fires any timers that have expired.
+      */
+    virtual void systemTick();
+
+    /**
+      * Determines when we next need to be called, so that the system tick can be suspended while the device is idle.
+      * @return The time at which the next timer expires, or MICROBIT_SYSTEM_TICK_NONE if there are no timers.
+      */
+    virtual unsigned long nextSystemTick();
+
+    /**
+      * Destructor for MicroBitTimer, so that we deregister ourselves as a systemComponent.
+      */
+    ~MicroBitTimer();
+
+    private:
+
+    /**
+      * Adds a timer to the heap.
+      * @param timer The timer to add.
+      * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if there is insufficient memory.
+      */
+    int add(MicroBitTimerEntry &timer);
+
+    /**
+      * Removes the timer at the given position in the heap.
+      * @param n The position of the timer.
+      */
+    void removeAt(int n);
+
+    /**
+      * Restores the heap order of every timer.
+      */
+    void rebuild();
+
+    /**
+      * Restores the heap order, by moving the timer at the given position up towards the top.
+      * @param n The position of the timer.
+      */
+    void siftUp(int n);
+
+    /**
+      * Restores the heap order, by moving the timer at the given position down towards the bottom.
+      * @param n The position of the timer.
+      */
+    void siftDown(int n);
+};
+
+#endif
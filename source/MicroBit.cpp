@@ -63,6 +63,7 @@ void bleDisconnectionCallback(const Gap::DisconnectionCallbackParams_t *reason)
   * uBit.resetButton; //The resetButton used for soft resets.
   * uBit.accelerometer; //The object that represents the inbuilt accelerometer
   * uBit.compass; //The object that represents the inbuilt compass(magnetometer)
+  * uBit.timer; //One shot and periodic timers, that raise events or call functions
   * uBit.io.P*; //Where P* is P0 to P16, P19 & P20 on the edge connector
   * @endcode
   */
@@ -78,6 +79,7 @@ MicroBit::MicroBit() :
     accelerometer(MICROBIT_ID_ACCELEROMETER, MMA8653_DEFAULT_ADDR),
     compass(MICROBIT_ID_COMPASS, MAG3110_DEFAULT_ADDR),
     thermometer(MICROBIT_ID_THERMOMETER),
+    timer(MICROBIT_ID_TIMER),
     io(MICROBIT_ID_IO_P0,MICROBIT_ID_IO_P1,MICROBIT_ID_IO_P2,
        MICROBIT_ID_IO_P3,MICROBIT_ID_IO_P4,MICROBIT_ID_IO_P5,
        MICROBIT_ID_IO_P6,MICROBIT_ID_IO_P7,MICROBIT_ID_IO_P8,
@@ -110,6 +112,20 @@ void MicroBit::init()
     addIdleComponent(&uBit.compass);
     addIdleComponent(&uBit.MessageBus);
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    // Make sure we wake up in time to deliver events held by throttled and debounced listeners.
+    addSystemComponent(&uBit.MessageBus);
+#endif
+
+    // Sensor updates are only of interest until the next one arrives, so don't let them fill the event queue.
+    MessageBus.setEventPolicy(MICROBIT_ID_ACCELEROMETER, MICROBIT_ACCELEROMETER_EVT_DATA_UPDATE, MESSAGE_BUS_EVENT_COALESCE);
+    MessageBus.setEventPolicy(MICROBIT_ID_COMPASS, MICROBIT_COMPASS_EVT_DATA_UPDATE, MESSAGE_BUS_EVENT_COALESCE);
+
+    // Users expect buttons to respond promptly, however busy the rest of the system is.
+    MessageBus.setEventPolicy(MICROBIT_ID_BUTTON_A, MICROBIT_EVT_ANY, MESSAGE_BUS_EVENT_LANE(MESSAGE_BUS_LANE_HIGHEST));
+    MessageBus.setEventPolicy(MICROBIT_ID_BUTTON_B, MICROBIT_EVT_ANY, MESSAGE_BUS_EVENT_LANE(MESSAGE_BUS_LANE_HIGHEST));
+    MessageBus.setEventPolicy(MICROBIT_ID_BUTTON_AB, MICROBIT_EVT_ANY, MESSAGE_BUS_EVENT_LANE(MESSAGE_BUS_LANE_HIGHEST));
+
     // Seed our random number generator
     seedRandom();
 
@@ -488,6 +504,67 @@ void MicroBit::systemTasks()
     fiber_flags &= ~MICROBIT_FLAG_DATA_READY;
 }
 
+/**
+  * Puts the processor into a power efficient sleep until an interrupt is pending.
+  * Called by the idle thread with interrupts disabled, so that one arriving after it last checked for work wakes the
+  * processor straight away, rather than being serviced first and then slept through. Returns with interrupts disabled.
+  */
+void MicroBit::systemWait()
+{
+    if (ble)
+    {
+        // The BLE stack sleeps using a supervisor call, which can't be made with interrupts disabled. It doesn't sleep
+        // if an interrupt has been serviced since it was last called though, so enabling them here can't lose one.
+        __enable_irq();
+        ble->waitForEvent();
+        __disable_irq();
+    }
+    else
+    {
+        // The processor still wakes when an interrupt is pending, even though it's held off.
+        __WFI();
+    }
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+/**
+  * Replaces the periodic system tick with a single wake up call, so that the processor can sleep through
+  * the ticks in between (see scheduler_tickless_sleep()).
+  *
+  * @param period The time until the wake up call, in microseconds.
+  */
+void MicroBit::systemTickSuspend(uint32_t period)
+{
+    systemTicker.detach();
+    systemWakeTimer.attach_us(this, &MicroBit::systemWake, period);
+}
+
+/**
+  * Cancels the wake up call, if it hasn't already happened, and restarts the periodic system tick.
+  *
+  * @param tick If non-zero, a system tick is also delivered straight away (from interrupt context), as one is due.
+  */
+void MicroBit::systemTickResume(int tick)
+{
+    systemWakeTimer.detach();
+
+    // A timeout in the past fires straight away.
+    if (tick)
+        systemWakeTimer.attach_us(this, &MicroBit::systemTick, 0);
+
+    systemTicker.attach(this, &MicroBit::systemTick, MICROBIT_DISPLAY_REFRESH_PERIOD);
+}
+
+/**
+  * Timer callback used to wake the processor from tickless idle.
+  * Prioritises the idle thread, so that it doesn't go on to sleep if we're called before it has done so.
+  */
+void MicroBit::systemWake()
+{
+    fiber_flags |= MICROBIT_FLAG_DATA_READY;
+}
+#endif
+
 /**
   * add a component to the array of components which invocate the systemTick member function during a systemTick
   * @param component The component to add.
@@ -22,12 +22,22 @@
   * @endcode
   */
 MicroBitButton::MicroBitButton(uint16_t id, PinName name, MicroBitButtonEventConfiguration eventConfiguration, PinMode mode) : pin(name, mode)
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    , wake(name)
+#endif
 {
     this->id = id;
     this->name = name;
     this->eventConfiguration = eventConfiguration;
     this->downStartTime = 0;
     this->sigma = 0;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    // We stop sampling the pin whilst the button is released, so have a press wake us up instead.
+    wake.mode(mode);
+    wake.fall(this, &MicroBitButton::onWake);
+#endif
+
     uBit.addSystemComponent(this);
 }
 
@@ -37,6 +47,11 @@ MicroBitButton::MicroBitButton(uint16_t id, PinName name, MicroBitButtonEventCon
   */
 void MicroBitButton::systemTick()
 {
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    // Any press that woke us is sampled below.
+    status &= ~MICROBIT_BUTTON_STATE_WAKE;
+#endif
+
     //
     // If the pin is pulled low (touched), increment our culumative counter.
     // otherwise, decrement it. We're essentially building a lazy follower here.
@@ -92,6 +107,36 @@ void MicroBitButton::systemTick()
     }
 }
 
+/**
+  * Determines when we next need to be called, so that the system tick can be suspended while the device is idle.
+  * A released button only needs sampling until it has settled, after which a press raises an interrupt that wakes
+  * the processor. A pressed button is sampled on every tick, to time holds and detect its release.
+  *
+  * @return MICROBIT_SYSTEM_TICK_NONE if the button is released and settled, or 0 otherwise.
+  */
+unsigned long MicroBitButton::nextSystemTick()
+{
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    if (sigma == MICROBIT_BUTTON_SIGMA_MIN && !(status & (MICROBIT_BUTTON_STATE | MICROBIT_BUTTON_STATE_WAKE)) && pin)
+        return MICROBIT_SYSTEM_TICK_NONE;
+#endif
+
+    return 0;
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+/**
+  * Interrupt handler for a button press. Ensures the button is sampled on the next system tick, even if the
+  * processor was about to suspend it.
+  */
+void MicroBitButton::onWake()
+{
+    // The interrupt is enough to wake the processor, but the press may come just before it goes to sleep instead.
+    // So make sure the idle thread knows we need the system tick when it makes its final check.
+    status |= MICROBIT_BUTTON_STATE_WAKE;
+}
+#endif
+
 /**
   * Tests if this Button is currently pressed.
   * @return 1 if this button is pressed, 0 otherwise.
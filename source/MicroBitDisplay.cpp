@@ -82,6 +82,16 @@ void MicroBitDisplay::systemTick()
     this->animationUpdate();
 }
 
+/**
+  * Determines when the display next needs to be strobed.
+  * A disabled display has no use for the system tick, allowing the scheduler to idle without it.
+  * @return 0 if the display is enabled, MICROBIT_SYSTEM_TICK_NONE otherwise.
+  */
+unsigned long MicroBitDisplay::nextSystemTick()
+{
+    return (uBit.flags & MICROBIT_FLAG_DISPLAY_RUNNING) ? 0 : MICROBIT_SYSTEM_TICK_NONE;
+}
+
 void MicroBitDisplay::renderFinish()
 {
     //kept inline to reduce overhead
@@ -47,6 +47,9 @@ void MicroBitEvent::fire(MicroBitEventLaunchMode mode)
 
     else if (mode == CREATE_AND_FIRE)
         uBit.MessageBus.process(*this);
+
+    else if (mode == CREATE_AND_QUEUE_PRIORITY)
+        uBit.MessageBus.send(*this, MESSAGE_BUS_LANE_HIGHEST);
 }
 
 /**
@@ -20,11 +20,49 @@ Fiber *idleFiber = NULL;                    // IDLE task - performs a power effi
 /*
  * Scheduler state.
  */
-Fiber *runQueue = NULL;                     // The list of runnable fibers.
+Fiber *runQueue[MICROBIT_FIBER_PRIORITY_LEVELS];    // The lists of runnable fibers, one per priority level.
 Fiber *sleepQueue = NULL;                   // The list of blocked fibers waiting on a fiber_sleep() operation.
-Fiber *waitQueue = NULL;                    // The list of blocked fibers waiting on an event.
+FiberWaitQueue *waitQueues = NULL;          // The set of queues of blocked fibers waiting on an event, one per event.
 Fiber *fiberPool = NULL;                    // Pool of unused fibers, just waiting for a job to do.
 
+#if MICROBIT_FIBER_PRIORITY_AGEING_MS > 0
+unsigned long runQueueServed[MICROBIT_FIBER_PRIORITY_LEVELS];    // The time at which each run queue was last scheduled.
+#endif
+
+FiberDeferredCall deferredCalls[MICROBIT_DEFERRED_CALL_QUEUE_SIZE];    // Calls deferred from interrupt context.
+uint8_t deferredHead = 0;                   // The index of the next deferred call to run.
+uint8_t deferredLength = 0;                 // The number of deferred calls waiting to run.
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+uint32_t ticklessRemainder = 0;             // The time slept through in tickless idle that has yet to be added to the system time (us).
+#endif
+
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+unsigned long watchdogTime = 0;             // The time at which the current fiber last yielded.
+uint8_t watchdogArmed = 0;                  // Non-zero if the watchdog is monitoring the current fiber.
+Fiber *watchdogFiber = NULL;                // The fiber that most recently exceeded its watchdog budget.
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+Fiber *fiberList = NULL;                    // List of every fiber ever created.
+FiberInvokeStatistics invokeStatistics;     // The cost of fork on block.
+unsigned long scheduledTime = 0;            // The time at which the current fiber was scheduled.
+#endif
+
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+void (*fiberLocalDestructors[MICROBIT_FIBER_LOCAL_SLOTS])(void *);     // The destructor registered for each fiber local storage slot.
+uint8_t fiberLocalSlots = 0;                // The number of fiber local storage slots allocated.
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+/*
+ * Pool of unused stack buffers, one list per size class.
+ * Each free buffer holds the address of the next free buffer of the same size in its first word.
+ */
+PROCESSOR_WORD_TYPE stackPool[MICROBIT_FIBER_STACK_POOL_CLASSES];
+FiberStackPoolStatistics stackPoolStatistics;
+#endif
+
 /*
  * Time since power on. Measured in milliseconds.
  * When stored as an unsigned long, this gives us approx 50 days between rollover, which is ample. :-)
@@ -77,6 +115,167 @@ void queue_fiber(Fiber *f, Fiber **queue)
     __enable_irq();
 }
 
+/**
+  * Utility function to make the given fiber runnable, by adding it to the run queue of its priority.
+  *
+  * @param f The fiber to make runnable.
+  */
+void queue_runnable_fiber(Fiber *f)
+{
+    Fiber **queue = &runQueue[f->priority];
+
+#if MICROBIT_FIBER_PRIORITY_AGEING_MS > 0
+    // A priority level only starts ageing once it has something to run.
+    // Fibers are also made runnable from interrupt context, so check and record this atomically.
+    __disable_irq();
+
+    if (*queue == NULL)
+        runQueueServed[f->priority] = ticks;
+
+    __enable_irq();
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    // Fibers with a deadline are held at the front of the run queue, in order of deadline.
+    // Those with equal deadlines are scheduled in the order in which they became runnable.
+    if (f->deadline != 0)
+    {
+        Fiber *p = NULL;
+        Fiber *n;
+
+        __disable_irq();
+
+        f->queue = queue;
+        n = *queue;
+
+        while (n != NULL && n->deadline != 0 && n->deadline <= f->deadline)
+        {
+            p = n;
+            n = n->next;
+        }
+
+        f->prev = p;
+        f->next = n;
+
+        if (p == NULL)
+            *queue = f;
+        else
+            p->next = f;
+
+        if (n != NULL)
+            n->prev = f;
+
+        __enable_irq();
+
+        return;
+    }
+#endif
+
+    queue_fiber(f, queue);
+}
+
+/**
+  * Determines if the given fiber is on one of the run queues.
+  *
+  * @param f The fiber to test.
+  * @return 1 if the fiber is runnable, 0 otherwise.
+  */
+int is_runnable_fiber(Fiber *f)
+{
+    return f->queue == &runQueue[f->priority];
+}
+
+/**
+  * Selects the run queue from which the next fiber should be scheduled.
+  * This is the highest priority non-empty queue, unless a lower priority queue has waited longer
+  * than MICROBIT_FIBER_PRIORITY_AGEING_MS to be scheduled.
+  *
+  * @return The selected run queue, or NULL if no fibers are runnable.
+  */
+Fiber **select_run_queue()
+{
+    Fiber **queue = NULL;
+
+#if MICROBIT_FIBER_PRIORITY_AGEING_MS > 0
+    // The run queues and their ageing times are also updated from interrupt context (as sleeping fibers are woken),
+    // so hold that off until we've made our choice.
+    __disable_irq();
+#endif
+
+    // With only a handful of levels, a bounded scan is as cheap as maintaining a bitmap
+    // (the Cortex M0 has no CLZ instruction to accelerate the latter anyway).
+    for (int i = MICROBIT_FIBER_PRIORITY_LEVELS - 1; i >= 0; i--)
+    {
+        if (runQueue[i] == NULL)
+            continue;
+
+#if MICROBIT_FIBER_PRIORITY_AGEING_MS > 0
+        // Remember the highest priority queue, but continue to look for any that are starving.
+        if (queue == NULL)
+            queue = &runQueue[i];
+
+        if (ticks - runQueueServed[i] >= MICROBIT_FIBER_PRIORITY_AGEING_MS)
+        {
+            queue = &runQueue[i];
+            break;
+        }
+#else
+        queue = &runQueue[i];
+        break;
+#endif
+    }
+
+#if MICROBIT_FIBER_PRIORITY_AGEING_MS > 0
+    if (queue != NULL)
+        runQueueServed[queue - runQueue] = ticks;
+
+    __enable_irq();
+#endif
+
+    return queue;
+}
+
+/**
+  * Utility function to add the given fiber to the sleep queue.
+  * The sleep queue is held in strict order of wake up time (stored in the context field of each fiber),
+  * so that scheduler_tick() need only inspect the head of the queue. Fibers with identical wake up times
+  * are woken in the order in which they went to sleep.
+  *
+  * @param f The fiber to add to the sleep queue. The context field must already hold the fiber's wake up time.
+  */
+void queue_sleeping_fiber(Fiber *f)
+{
+    Fiber *p = NULL;
+    Fiber *n;
+
+    __disable_irq();
+
+    // Record which queue this fiber is on.
+    f->queue = &sleepQueue;
+
+    // Find the first fiber due to wake strictly later than us, and insert ourselves before it.
+    n = sleepQueue;
+
+    while (n != NULL && n->context <= f->context)
+    {
+        p = n;
+        n = n->next;
+    }
+
+    f->prev = p;
+    f->next = n;
+
+    if (p == NULL)
+        sleepQueue = f;
+    else
+        p->next = f;
+
+    if (n != NULL)
+        n->prev = f;
+
+    __enable_irq();
+}
+
 /**
   * Utility function to the given fiber from whichever queue it is currently stored on. 
   * @param f the fiber to remove.
@@ -132,16 +331,144 @@ Fiber *getFiberContext()
 
         f->stack_bottom = 0;
         f->stack_top = 0;
+        f->generation = 0;
+        f->joiners = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        __disable_irq();
+        f->list_next = fiberList;
+        fiberList = f;
+        __enable_irq();
+#endif
     }    
    
     // Ensure this fiber is in suitable state for reuse. 
     f->flags = 0;
+    f->priority = MICROBIT_FIBER_DEFAULT_PRIORITY;
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    f->deadline = 0;
+#endif
     f->tcb.stack_base = CORTEX_M0_STACK_BASE;
 
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+    for (int i = 0; i < MICROBIT_FIBER_LOCAL_SLOTS; i++)
+        f->local[i] = NULL;
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    f->switches = 0;
+    f->run_time = 0;
+    f->max_stack_depth = 0;
+    f->forks = 0;
+#endif
+
     return f;
 }
 
 
+/**
+  * Allocates a buffer large enough to hold a fiber stack of the given depth.
+  * If stack pooling is enabled, the buffer is taken from the pool of the smallest suitable size class
+  * where possible. Otherwise, a buffer is allocated from the heap.
+  *
+  * @param stackDepth The number of bytes of stack the buffer needs to hold.
+  * @param bufferSize Updated with the size of the buffer allocated.
+  * @return The address of the buffer, or 0 if no memory is available.
+  */
+PROCESSOR_WORD_TYPE allocate_stack_buffer(uint32_t stackDepth, uint32_t *bufferSize)
+{
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+    uint32_t size = MICROBIT_FIBER_STACK_POOL_MIN_SIZE;
+    PROCESSOR_WORD_TYPE buffer;
+
+    for (int i = 0; i < MICROBIT_FIBER_STACK_POOL_CLASSES; i++)
+    {
+        if (stackDepth <= size)
+        {
+            *bufferSize = size;
+
+            __disable_irq();
+            buffer = stackPool[i];
+
+            if (buffer != 0)
+            {
+                stackPool[i] = *((PROCESSOR_WORD_TYPE *)buffer);
+                stackPoolStatistics.pooled -= size;
+                stackPoolStatistics.hits[i]++;
+            }
+            __enable_irq();
+
+            if (buffer != 0)
+                return buffer;
+
+            stackPoolStatistics.misses[i]++;
+            return (PROCESSOR_WORD_TYPE) malloc(size);
+        }
+
+        size <<= 1;
+    }
+
+    stackPoolStatistics.misses[MICROBIT_FIBER_STACK_POOL_CLASSES]++;
+#endif
+
+    // To ease heap churn, we choose the next largest multple of 32 bytes.
+    *bufferSize = (stackDepth + 32) & 0xffffffe0;
+
+    return (PROCESSOR_WORD_TYPE) malloc(*bufferSize);
+}
+
+/**
+  * Releases a buffer previously obtained from allocate_stack_buffer().
+  * If stack pooling is enabled, the buffer is returned to the pool if it belongs to a size class and
+  * the pool has room for it. Otherwise, the buffer is returned to the heap.
+  *
+  * @param buffer The address of the buffer to release.
+  * @param bufferSize The size of the buffer.
+  */
+void release_stack_buffer(PROCESSOR_WORD_TYPE buffer, uint32_t bufferSize)
+{
+    if (buffer == 0)
+        return;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+    uint32_t size = MICROBIT_FIBER_STACK_POOL_MIN_SIZE;
+
+    for (int i = 0; i < MICROBIT_FIBER_STACK_POOL_CLASSES; i++)
+    {
+        if (bufferSize == size)
+        {
+            if (stackPoolStatistics.pooled + size > MICROBIT_FIBER_STACK_POOL_LIMIT)
+                break;
+
+            __disable_irq();
+            *((PROCESSOR_WORD_TYPE *)buffer) = stackPool[i];
+            stackPool[i] = buffer;
+            stackPoolStatistics.pooled += size;
+            __enable_irq();
+
+            return;
+        }
+
+        size <<= 1;
+    }
+#else
+    (void)bufferSize; /* -Wunused-parameter */
+#endif
+
+    free((void *)buffer);
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+/**
+  * Provides usage statistics for the pool of fiber stack buffers.
+  * @return The statistics gathered since power on.
+  */
+const FiberStackPoolStatistics *fiber_stack_pool_statistics()
+{
+    return &stackPoolStatistics;
+}
+#endif
+
 /**
   * Initialises the Fiber scheduler. 
   * Creates a Fiber context around the calling thread, and adds it to the run queue as the current thread.
@@ -154,16 +481,16 @@ void scheduler_init()
     currentFiber = getFiberContext();
     
     // Add ourselves to the run queue.
-    queue_fiber(currentFiber, &runQueue);
+    queue_runnable_fiber(currentFiber);
 
     // Create the IDLE fiber.
     // Configure the fiber to directly enter the idle task.
     idleFiber = getFiberContext();
     idleFiber->tcb.SP = CORTEX_M0_STACK_BASE - 0x04;    
-    idleFiber->tcb.LR = (uint32_t) &idle_task;
+    idleFiber->tcb.LR = (PROCESSOR_WORD_TYPE) &idle_task;
 
-    // Register to receive events in the NOTIFY channel - this is used to implement wait-notify semantics
-    uBit.MessageBus.listen(MICROBIT_ID_NOTIFY, MICROBIT_EVT_ANY, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
+    // Register to receive events in the NOTIFY_ONE channel - this is used to implement wait-notify semantics.
+    // Events in the NOTIFY channel are delivered through the wait queue of the fibers waiting on them.
     uBit.MessageBus.listen(MICROBIT_ID_NOTIFY_ONE, MICROBIT_EVT_ANY, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
 
     // Flag that we now have a scheduler running
@@ -177,74 +504,247 @@ void scheduler_init()
   */
 void scheduler_tick()
 {
-    Fiber *f = sleepQueue;
-    Fiber *t;
+    Fiber *f;
     
     // increment our real-time counter.
     ticks += FIBER_TICK_PERIOD_MS;
     
     // Check the sleep queue, and wake up any fibers as necessary.
-    while (f != NULL)
+    // The queue is ordered by wake up time, so we can stop as soon as we find a fiber that isn't due yet.
+    while ((f = sleepQueue) != NULL && ticks >= f->context)
     {
-        t = f->next;        
-        
-        if (ticks >= f->context)
-        {
-            // Wakey wakey!
-            dequeue_fiber(f);
-            queue_fiber(f,&runQueue);
-        }
-        
-        f = t;
+        // Wakey wakey!
+        dequeue_fiber(f);
+        queue_runnable_fiber(f);
+    }
+
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+    // If the current fiber has run for too long without yielding, raise the alarm (once).
+    if (watchdogArmed && ticks - watchdogTime >= MICROBIT_FIBER_WATCHDOG_MS)
+    {
+        watchdogArmed = 0;
+        watchdogFiber = currentFiber;
+
+        MicroBitEvent(MICROBIT_ID_SCHEDULER, MICROBIT_SCHEDULER_EVT_WATCHDOG);
     }
+#endif
 }
 
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
 /**
-  * Event callback. Called from the message bus whenever an event is raised. 
-  * Checks to determine if any fibers blocked on the wait queue need to be woken up 
-  * and made runnable due to the event.
+  * Restarts the watchdog budget of the current fiber. Called whenever a fiber yields.
   */
-void scheduler_event(MicroBitEvent evt)
+void watchdog_restart()
 {
-    Fiber *f = waitQueue;
-    Fiber *t;
-    int notifyOneComplete = 0;
-    
-    // Check the wait queue, and wake up any fibers as necessary.
-    while (f != NULL)
+    watchdogTime = ticks;
+    watchdogArmed = 1;
+}
+
+/**
+  * Determines which fiber most recently ran for longer than MICROBIT_FIBER_WATCHDOG_MS without yielding.
+  * @return The offending fiber, or NULL if the watchdog has never been triggered.
+  */
+Fiber *scheduler_watchdog_fiber()
+{
+    return watchdogFiber;
+}
+#endif
+
+/**
+  * Determines when the scheduler next needs to wake a sleeping fiber.
+  * @return The system time (in milliseconds) at which the next sleeping fiber is due to wake,
+  * or MICROBIT_SYSTEM_TICK_NONE if there are no sleeping fibers.
+  */
+unsigned long scheduler_next_wakeup()
+{
+    Fiber *f = sleepQueue;
+
+    return f == NULL ? MICROBIT_SYSTEM_TICK_NONE : f->context;
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+/**
+  * Determines the time by which the processor must be woken, if the system tick is suspended.
+  * This is when the next sleeping fiber is due to wake, or when any system component needs its next tick,
+  * whichever is sooner.
+  *
+  * @return That time, or the current system time if there is work to do now: a runnable fiber, a deferred call,
+  * or an idle component with work pending.
+  */
+unsigned long scheduler_tickless_deadline()
+{
+    unsigned long deadline, t;
+
+    if (!scheduler_runqueue_empty() || deferredLength || fiber_flags & MICROBIT_FLAG_DATA_READY)
+        return ticks;
+
+    // Never sleep through work that an idle component is waiting to do.
+    for (int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if (uBit.idleThreadComponents[i] != NULL && uBit.idleThreadComponents[i]->isIdleCallbackNeeded())
+            return ticks;
+
+    deadline = scheduler_next_wakeup();
+
+    for (int i = 0; i < MICROBIT_SYSTEM_COMPONENTS; i++)
     {
-        t = f->next;        
-    
-        // extract the event data this fiber is blocked on.    
-        uint16_t id = f->context & 0xFFFF;
-        uint16_t value = (f->context & 0xFFFF0000) >> 16;
-       
-        // Special case for the NOTIFY_ONE channel...
-        if ((evt.source == MICROBIT_ID_NOTIFY_ONE && id == MICROBIT_ID_NOTIFY) && (value == MICROBIT_EVT_ANY || value == evt.value))
+        if (uBit.systemTickComponents[i] != NULL)
         {
-            if (!notifyOneComplete) 
-            {
-                // Wakey wakey!
-                dequeue_fiber(f);
-                queue_fiber(f,&runQueue);
-                notifyOneComplete = 1;
-            }
-        }
+            t = uBit.systemTickComponents[i]->nextSystemTick();
 
-        // Normal case.
-        else if ((id == MICROBIT_ID_ANY || id == evt.source) && (value == MICROBIT_EVT_ANY || value == evt.value))
-        {
-            // Wakey wakey!
-            dequeue_fiber(f);
-            queue_fiber(f,&runQueue);
+            if (t < deadline)
+                deadline = t;
         }
-        
-        f = t;
     }
 
-    // Unregister this event, as we've woken up all the fibers with this match.
-    if (evt.source != MICROBIT_ID_NOTIFY && evt.source != MICROBIT_ID_NOTIFY_ONE)
-        uBit.MessageBus.ignore(evt.source, evt.value, scheduler_event);
+    return deadline;
+}
+
+/**
+  * Suspends the system tick and puts the processor into a power efficient sleep until the next sleeping fiber is due
+  * to wake or a system component needs its next tick (but for no longer than MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS),
+  * or until an interrupt occurs. The system time is then brought up to date, and the system tick restarted.
+  *
+  * Nothing is done if there is work to do, or if the processor is due to be woken within a couple of ticks anyway.
+  * Only suspending the system tick and sleeping are device specific (see MicroBit::systemTickSuspend(),
+  * MicroBit::systemTickResume() and MicroBit::systemWait()).
+  *
+  * @return 1 if the system tick was suspended, 0 otherwise.
+  */
+int scheduler_tickless_sleep()
+{
+    unsigned long deadline = scheduler_tickless_deadline();
+    uint32_t start, elapsed, period;
+
+    // If we're due to wake within a couple of ticks, it's not worth stopping the system tick.
+    if (deadline <= ticks + 2*FIBER_TICK_PERIOD_MS)
+        return 0;
+
+    period = deadline - ticks;
+
+    if (period > MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS)
+        period = MICROBIT_FIBER_TICKLESS_MAX_SLEEP_MS;
+
+    deadline = ticks + period;
+
+    // Replace the periodic system tick with a single wake up call.
+    uBit.systemTickSuspend(period * 1000);
+    start = us_ticker_read();
+
+    // From here on, an interrupt is held off until we're asleep, and then wakes us straight away.
+    // So make sure that none has given us work (or an earlier deadline) since we last looked, before going to sleep.
+    __disable_irq();
+
+    if (scheduler_tickless_deadline() >= deadline)
+        uBit.systemWait();
+
+    // Determine how many whole ticks we slept through, carrying any remainder over to the next sleep.
+    elapsed = us_ticker_read() - start + ticklessRemainder;
+    ticklessRemainder = elapsed % (FIBER_TICK_PERIOD_MS * 1000);
+    elapsed = elapsed / (FIBER_TICK_PERIOD_MS * 1000);
+
+    // Catch up. The final tick is delivered from interrupt context as soon as the system tick is restarted, so that any
+    // fibers now due are woken and our components are serviced, just as if the system tick had been running all along.
+    if (elapsed > 0)
+        ticks += (elapsed - 1) * FIBER_TICK_PERIOD_MS;
+
+    __enable_irq();
+
+    uBit.systemTickResume(elapsed > 0);
+
+    return 1;
+}
+#endif
+
+/**
+  * Finds the wait queue used by fibers blocked on the given event, creating it if necessary.
+  *
+  * Each wait queue is registered with the message bus exactly once, and persists for the lifetime of the
+  * program. This avoids adding and removing a listener every time a fiber waits, and allows an event to
+  * be delivered directly to the fibers waiting on it.
+  *
+  * @param id The ID field of the event.
+  * @param value The VALUE field of the event.
+  * @param create If set, a new wait queue is created if one does not already exist.
+  * @return The wait queue for the given event, or NULL if it does not exist and could not be created.
+  */
+FiberWaitQueue *get_wait_queue(uint16_t id, uint16_t value, int create)
+{
+    FiberWaitQueue *q = waitQueues;
+
+    while (q != NULL)
+    {
+        if (q->id == id && q->value == value)
+            return q;
+
+        q = q->next;
+    }
+
+    if (!create)
+        return NULL;
+
+    q = new FiberWaitQueue();
+
+    if (q == NULL)
+        return NULL;
+
+    q->id = id;
+    q->value = value;
+    q->queue = NULL;
+
+    // Register to receive this event, so we can wake up the fibers waiting on it when it happens.
+    uBit.MessageBus.listen(id, value, scheduler_wait_event, q, MESSAGE_BUS_LISTENER_IMMEDIATE);
+
+    __disable_irq();
+    q->next = waitQueues;
+    waitQueues = q;
+    __enable_irq();
+
+    return q;
+}
+
+/**
+  * Event callback. Called from the message bus whenever an event is raised that one or more fibers have waited on.
+  * Wakes up all the fibers blocked on the given wait queue, and makes them runnable.
+  *
+  * @param evt The event raised.
+  * @param param The wait queue associated with the event.
+  */
+void scheduler_wait_event(MicroBitEvent evt, void *param)
+{
+    FiberWaitQueue *q = (FiberWaitQueue *)param;
+    Fiber *f;
+
+    (void)evt; /* -Wunused-parameter */
+
+    // Wakey wakey!
+    while ((f = q->queue) != NULL)
+    {
+        dequeue_fiber(f);
+        queue_runnable_fiber(f);
+    }
+}
+
+/**
+  * Event callback. Called from the message bus whenever an event is raised on the NOTIFY_ONE channel.
+  * Wakes up the first fiber waiting on the NOTIFY channel with the same value (or any value), and makes it runnable.
+  *
+  * @param evt The event raised.
+  */
+void scheduler_event(MicroBitEvent evt)
+{
+    FiberWaitQueue *q = get_wait_queue(MICROBIT_ID_NOTIFY, evt.value, 0);
+
+    if (q == NULL || q->queue == NULL)
+        q = get_wait_queue(MICROBIT_ID_NOTIFY, MICROBIT_EVT_ANY, 0);
+
+    if (q != NULL && q->queue != NULL)
+    {
+        // Wakey wakey!
+        Fiber *f = q->queue;
+
+        dequeue_fiber(f);
+        queue_runnable_fiber(f);
+    }
 }
 
 
@@ -259,6 +759,19 @@ void scheduler_event(MicroBitEvent evt)
   * @param t The period of time to sleep, in milliseconds.
   */
 void fiber_sleep(unsigned long t)
+{
+    fiber_sleep_until(ticks + t);
+}
+
+/**
+  * Blocks the calling thread until the given system time.
+  * Unlike fiber_sleep(), the wake up time does not depend on when the call is made, so loops
+  * that sleep until a fixed multiple of a period do not drift.
+  *
+  * @param t The system time at which to wake up, in milliseconds (as given by ticks).
+  * If this has already passed, the fiber is woken at the next scheduler tick.
+  */
+void fiber_sleep_until(unsigned long t)
 {
     Fiber *f = currentFiber;
 
@@ -276,14 +789,14 @@ void fiber_sleep(unsigned long t)
                 f = forkedFiber;
     }
 
-    // Calculate and store the time we want to wake up.
-    f->context = ticks + t;
+    // Store the time we want to wake up.
+    f->context = t;
     
     // Remove fiber from the run queue
     dequeue_fiber(f);
         
     // Add fiber to the sleep queue. We maintain strict ordering here to reduce lookup times.
-    queue_fiber(f, &sleepQueue);
+    queue_sleeping_fiber(f);
     
     // Finally, enter the scheduler.
     schedule();
@@ -303,6 +816,14 @@ void fiber_sleep(unsigned long t)
 void fiber_wait_for_event(uint16_t id, uint16_t value)
 {
     Fiber *f = currentFiber;
+    FiberWaitQueue *q;
+
+    // Find the queue of fibers waiting on this event.
+    // If we're out of memory, there's nothing we can do, so don't block.
+    q = get_wait_queue(id, value, 1);
+
+    if (q == NULL)
+        return;
 
     // Sleep is a blocking call, so if we'r ein a fork on block context,
     // it's time to spawn a new fiber...
@@ -324,18 +845,127 @@ void fiber_wait_for_event(uint16_t id, uint16_t value)
     // Remove ourselve from the run queue
     dequeue_fiber(f);
         
-    // Add ourselves to the sleep queue. We maintain strict ordering here to reduce lookup times.
-    queue_fiber(f, &waitQueue);
-    
-    // Register to receive this event, so we can wake up the fiber when it happens.
-    // Special case for teh notify channel, as we always stay registered for that.
-    if (id != MICROBIT_ID_NOTIFY && id != MICROBIT_ID_NOTIFY_ONE)
-        uBit.MessageBus.listen(id, value, scheduler_event, MESSAGE_BUS_LISTENER_IMMEDIATE);
+    // Add ourselves to the queue of fibers waiting on this event.
+    queue_fiber(f, &q->queue);
+
+    // Finally, enter the scheduler.
+    schedule();
+}
+
+/**
+  * Blocks the calling thread on the given wait queue, until it is woken by fiber_wake_one() or fiber_wake_all().
+  * This is the building block for synchronisation primitives that park fibers on their own queues,
+  * rather than on the message bus.
+  *
+  * @param queue The wait queue to block on.
+  */
+void fiber_wait_on(Fiber **queue)
+{
+    Fiber *f = currentFiber;
+
+    // Waiting is a blocking call, so if we're in a fork on block context,
+    // it's time to spawn a new fiber...
+    if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
+    {
+        forkedFiber = getFiberContext();
+
+        // If we're out of memory, there's nothing we can do. 
+        // keep running in the context of the current thread as a best effort.
+        if (forkedFiber != NULL)
+            f = forkedFiber;
+    }
+
+    // Move ourselves from the run queue to the given wait queue.
+    dequeue_fiber(f);
+    queue_fiber(f, queue);
 
     // Finally, enter the scheduler.
     schedule();
 }
 
+/**
+  * Blocks the calling thread until the given fiber completes.
+  * Fibers are recycled via the fiber pool once they complete, so the caller identifies the fiber by
+  * both its context and its generation (as it was when the fiber was created). If the generation has
+  * since changed, the fiber has already completed and this call returns immediately.
+  *
+  * @param f The fiber to wait for.
+  * @param generation The generation of the fiber to wait for.
+  * @return MICROBIT_OK once the fiber has completed, or MICROBIT_INVALID_PARAMETER if f is NULL or is the calling fiber.
+  */
+int fiber_join(Fiber *f, uint32_t generation)
+{
+    if (f == NULL || f == currentFiber)
+        return MICROBIT_INVALID_PARAMETER;
+
+    // Wait on the fiber's own list of joiners. It is woken by release_fiber().
+    if (f->generation == generation)
+        fiber_wait_on(&f->joiners);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Changes the priority of the given fiber. If the fiber is runnable, it is moved to the tail of its new run queue.
+  *
+  * @param f The fiber to change.
+  * @param priority The new priority, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if f is NULL or the priority is out of range.
+  */
+int fiber_set_priority(Fiber *f, int priority)
+{
+    if (f == NULL || priority < 0 || priority >= MICROBIT_FIBER_PRIORITY_LEVELS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    if (is_runnable_fiber(f))
+    {
+        dequeue_fiber(f);
+        f->priority = priority;
+        queue_runnable_fiber(f);
+    }
+    else
+    {
+        f->priority = priority;
+    }
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Makes the fiber at the head of the given wait queue runnable.
+  *
+  * @param queue The wait queue to wake a fiber from.
+  * @return The fiber that was woken, or NULL if the queue was empty.
+  */
+Fiber *fiber_wake_one(Fiber **queue)
+{
+    Fiber *f = *queue;
+
+    if (f != NULL)
+    {
+        dequeue_fiber(f);
+        queue_runnable_fiber(f);
+    }
+
+    return f;
+}
+
+/**
+  * Makes every fiber on the given wait queue runnable.
+  *
+  * @param queue The wait queue to wake fibers from.
+  * @return The number of fibers that were woken.
+  */
+int fiber_wake_all(Fiber **queue)
+{
+    int woken = 0;
+
+    while (fiber_wake_one(queue) != NULL)
+        woken++;
+
+    return woken;
+}
+
 /**
   * Executes the given function asynchronously.  
   * 
@@ -354,10 +984,12 @@ int invoke(void (*entry_fn)(void))
     if (entry_fn == NULL)
         return MICROBIT_INVALID_PARAMETER;
 
-    if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
+    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_DEDICATED_STACK))
     {
         // If we attempt a fork on block whilst already in  fork n block context,
         // simply launch a fiber to deal with the request and we're done.
+        // The same applies to fibers with a dedicated stack, as a forked fiber could not restore its stack
+        // without overwriting that of its parent.
         create_fiber(entry_fn);
         return MICROBIT_OK;
     }
@@ -382,6 +1014,11 @@ int invoke(void (*entry_fn)(void))
     // execute the function directly. If the code tries to block, we detect this and
     // spawn a thread to deal with it.
     currentFiber->flags |= MICROBIT_FIBER_FLAG_FOB;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    invokeStatistics.invocations++;
+#endif
+
     entry_fn();    
     currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
 
@@ -412,10 +1049,12 @@ int invoke(void (*entry_fn)(void *), void *param)
     if (entry_fn == NULL)
         return MICROBIT_INVALID_PARAMETER;
 
-    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_PARENT | MICROBIT_FIBER_FLAG_CHILD))
+    if (currentFiber->flags & (MICROBIT_FIBER_FLAG_FOB | MICROBIT_FIBER_FLAG_PARENT | MICROBIT_FIBER_FLAG_CHILD | MICROBIT_FIBER_FLAG_DEDICATED_STACK))
     {
         // If we attempt a fork on block whilst already in a fork on block context,
         // simply launch a fiber to deal with the request and we're done.
+        // The same applies to fibers with a dedicated stack, as a forked fiber could not restore its stack
+        // without overwriting that of its parent.
         create_fiber(entry_fn, param);
         return MICROBIT_OK;
     }
@@ -440,6 +1079,11 @@ int invoke(void (*entry_fn)(void *), void *param)
     // execute the function directly. If the code tries to block, we detect this and
     // spawn a thread to deal with it.
     currentFiber->flags |= MICROBIT_FIBER_FLAG_FOB;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    invokeStatistics.invocations++;
+#endif
+
     entry_fn(param);    
     currentFiber->flags &= ~MICROBIT_FIBER_FLAG_FOB;
 
@@ -475,10 +1119,10 @@ void launch_new_fiber_param(void (*ep)(void *), void (*cp)(void *), void *pm)
     release_fiber(pm);
 }
 
-Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
+Fiber *__create_fiber(PROCESSOR_WORD_TYPE ep, PROCESSOR_WORD_TYPE cp, PROCESSOR_WORD_TYPE pm, int parameterised, int priority)
 {
     // Validate our parameters.
-    if (ep == 0 || cp == 0)
+    if (ep == 0 || cp == 0 || priority < 0 || priority >= MICROBIT_FIBER_PRIORITY_LEVELS)
         return NULL;
     
     // Allocate a TCB from the new fiber. This will come from the fiber pool if availiable,
@@ -489,16 +1133,17 @@ Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
     if (newFiber == NULL)
         return NULL;
     
-    newFiber->tcb.R0 = (uint32_t) ep;
-    newFiber->tcb.R1 = (uint32_t) cp;
-    newFiber->tcb.R2 = (uint32_t) pm;
+    newFiber->tcb.R0 = ep;
+    newFiber->tcb.R1 = cp;
+    newFiber->tcb.R2 = pm;
 
     // Set the stack and assign the link register to refer to the appropriate entry point wrapper.
     newFiber->tcb.SP = CORTEX_M0_STACK_BASE - 0x04;    
-    newFiber->tcb.LR = parameterised ? (uint32_t) &launch_new_fiber_param : (uint32_t) &launch_new_fiber;
+    newFiber->tcb.LR = parameterised ? (PROCESSOR_WORD_TYPE) &launch_new_fiber_param : (PROCESSOR_WORD_TYPE) &launch_new_fiber;
     
     // Add new fiber to the run queue.
-    queue_fiber(newFiber, &runQueue);
+    newFiber->priority = priority;
+    queue_runnable_fiber(newFiber);
         
     return newFiber;
 }
@@ -508,11 +1153,12 @@ Fiber *__create_fiber(uint32_t ep, uint32_t cp, uint32_t pm, int parameterised)
   *
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The new Fiber, or NULL if the parameters are invalid or there is insufficient memory.
   */
-Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void))
+Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void), int priority)
 {
-    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, 0, 0);
+    return __create_fiber((PROCESSOR_WORD_TYPE) entry_fn, (PROCESSOR_WORD_TYPE) completion_fn, 0, 0, priority);
 }
 
 
@@ -522,11 +1168,186 @@ Fiber *create_fiber(void (*entry_fn)(void), void (*completion_fn)(void))
   * @param entry_fn The function the new Fiber will begin execution in.
   * @param param an untyped parameter passed into the entry_fn anf completion_fn.
   * @param completion_fn The function called when the thread completes execution of entry_fn.  
-  * @return The new Fiber.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The new Fiber, or NULL if the parameters are invalid or there is insufficient memory.
+  */
+Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *), int priority)
+{
+    return __create_fiber((PROCESSOR_WORD_TYPE) entry_fn, (PROCESSOR_WORD_TYPE) completion_fn, (PROCESSOR_WORD_TYPE) param, 1, priority);
+}
+
+/**
+  * Gives the given fiber its own dedicated stack, on which it will execute directly rather than
+  * having its stack paged in and out of the system stack.
+  * Must be called before the fiber has first been scheduled.
+  *
+  * @param f The fiber to update.
+  * @param stack_size The size of the stack to allocate, in bytes.
+  * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if the stack could not be allocated.
+  */
+int allocate_dedicated_stack(Fiber *f, uint32_t stack_size)
+{
+    // Round up to a whole number of words.
+    stack_size = (stack_size + 3) & 0xfffffffc;
+
+    // Any existing stack buffer is reused if it is big enough.
+    if (f->stack_top - f->stack_bottom < stack_size)
+    {
+        PROCESSOR_WORD_TYPE buffer = (PROCESSOR_WORD_TYPE) malloc(stack_size);
+
+        if (buffer == 0)
+            return MICROBIT_NO_RESOURCES;
+
+        release_stack_buffer(f->stack_bottom, f->stack_top - f->stack_bottom);
+
+        f->stack_bottom = buffer;
+        f->stack_top = buffer + stack_size;
+    }
+
+    // Execute the fiber directly from the top of its stack buffer.
+    f->tcb.stack_base = f->stack_top;
+    f->tcb.SP = f->stack_top - 0x04;
+    f->flags |= MICROBIT_FIBER_FLAG_DEDICATED_STACK;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Creates a new Fiber with its own dedicated stack, and launches it.
+  *
+  * @param entry_fn The function the new Fiber will begin execution in.
+  * @param stack_size The size of the fiber's stack, in bytes. This must also accommodate any interrupt handlers.
+  * @param completion_fn The function called when the thread completes execution of entry_fn.
+  * @return The new Fiber. If the stack could not be allocated, the fiber is still created, but uses the system stack as normal.
+  */
+Fiber *create_dedicated_fiber(void (*entry_fn)(void), uint32_t stack_size, void (*completion_fn)(void))
+{
+    Fiber *f = __create_fiber((PROCESSOR_WORD_TYPE) entry_fn, (PROCESSOR_WORD_TYPE) completion_fn, 0, 0, MICROBIT_FIBER_DEFAULT_PRIORITY);
+
+    if (f != NULL)
+        allocate_dedicated_stack(f, stack_size);
+
+    return f;
+}
+
+/**
+  * Creates a new parameterised Fiber with its own dedicated stack, and launches it.
+  *
+  * @param entry_fn The function the new Fiber will begin execution in.
+  * @param param an untyped parameter passed into the entry_fn anf completion_fn.
+  * @param stack_size The size of the fiber's stack, in bytes. This must also accommodate any interrupt handlers.
+  * @param completion_fn The function called when the thread completes execution of entry_fn.
+  * @return The new Fiber. If the stack could not be allocated, the fiber is still created, but uses the system stack as normal.
+  */
+Fiber *create_dedicated_fiber(void (*entry_fn)(void *), void *param, uint32_t stack_size, void (*completion_fn)(void *))
+{
+    Fiber *f = __create_fiber((PROCESSOR_WORD_TYPE) entry_fn, (PROCESSOR_WORD_TYPE) completion_fn, (PROCESSOR_WORD_TYPE) param, 1, MICROBIT_FIBER_DEFAULT_PRIORITY);
+
+    if (f != NULL)
+        allocate_dedicated_stack(f, stack_size);
+
+    return f;
+}
+
+/**
+  * Entry point of fibers created by create_periodic_fiber().
+  * Runs the task once per period, until it is cancelled.
+  */
+void periodic_fiber(void *param)
+{
+    FiberPeriodicTask *task = (FiberPeriodicTask *)param;
+    unsigned long period;
+
+    while ((period = task->period) != 0)
+    {
+        // Each run is due to complete by the time of the next release.
+        unsigned long deadline = task->release + period;
+
+        task->entry_fn(task->param);
+
+        task->release = deadline;
+
+        // If we've overrun, skip any releases that have already passed, rather than trying to catch up.
+        if (ticks > deadline)
+        {
+            task->missed++;
+
+            while (ticks >= task->release + period)
+            {
+                task->release += period;
+                task->missed++;
+            }
+        }
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+        // Sleep with the deadline of the next run, so that we're queued in order of it as soon as we're released.
+        currentFiber->deadline = task->release + period;
+#endif
+
+        fiber_sleep_until(task->release);
+    }
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    currentFiber->deadline = 0;
+#endif
+
+    delete task;
+}
+
+/**
+  * Creates a new Fiber that calls the given function once every period, and launches it.
+  * The first call is made immediately. If a call completes after the next is due, a deadline is missed,
+  * and any releases that have already passed are skipped rather than run back to back.
+  *
+  * @param entry_fn The function to call each period.
+  * @param param an untyped parameter passed into the entry_fn.
+  * @param period The time between calls, in milliseconds.
+  * @param priority The priority of the new Fiber, between MICROBIT_FIBER_PRIORITY_LOWEST and MICROBIT_FIBER_PRIORITY_HIGHEST.
+  * @return The task, or NULL if the parameters are invalid or there is insufficient memory.
+  */
+FiberPeriodicTask *create_periodic_fiber(void (*entry_fn)(void *), void *param, unsigned long period, int priority)
+{
+    if (entry_fn == NULL || period == 0)
+        return NULL;
+
+    FiberPeriodicTask *task = new FiberPeriodicTask();
+
+    if (task == NULL)
+        return NULL;
+
+    task->entry_fn = entry_fn;
+    task->param = param;
+    task->period = period;
+    task->release = ticks;
+    task->missed = 0;
+    task->fiber = create_fiber(periodic_fiber, task, release_fiber, priority);
+
+    if (task->fiber == NULL)
+    {
+        delete task;
+        return NULL;
+    }
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    // The first run is due to complete by the second release, and is queued in order of that, just as later runs are.
+    dequeue_fiber(task->fiber);
+    task->fiber->deadline = task->release + period;
+    queue_runnable_fiber(task->fiber);
+#endif
+
+    return task;
+}
+
+/**
+  * Stops a task created by create_periodic_fiber().
+  * The task's fiber completes at its next release, when the task is freed.
+  *
+  * @param task The task to stop. This must not be used once this function has been called.
   */
-Fiber *create_fiber(void (*entry_fn)(void *), void *param, void (*completion_fn)(void *))
+void cancel_periodic_fiber(FiberPeriodicTask *task)
 {
-    return __create_fiber((uint32_t) entry_fn, (uint32_t)completion_fn, (uint32_t) param, 1);
+    if (task != NULL)
+        task->period = 0;
 }
 
 /**
@@ -546,9 +1367,38 @@ void release_fiber(void * param)
   */
 void release_fiber(void)
 {  
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+    // Clean up our fiber local storage, while we're still able to block if need be.
+    for (int i = 0; i < fiberLocalSlots; i++)
+    {
+        void *value = currentFiber->local[i];
+
+        if (value != NULL && fiberLocalDestructors[i] != NULL)
+        {
+            currentFiber->local[i] = NULL;
+            fiberLocalDestructors[i](value);
+        }
+    }
+#endif
+
     // Remove ourselves form the runqueue.
     dequeue_fiber(currentFiber);
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STACK_POOL)
+    // We'll never need our stack again, so return our stack buffer for use by other fibers.
+    // (unless we're executing on it!)
+    if (!(currentFiber->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK))
+    {
+        release_stack_buffer(currentFiber->stack_bottom, currentFiber->stack_top - currentFiber->stack_bottom);
+        currentFiber->stack_bottom = 0;
+        currentFiber->stack_top = 0;
+    }
+#endif
+
+    // Mark this incarnation of the fiber as complete, and wake anything waiting for it.
+    currentFiber->generation++;
+    fiber_wake_all(&currentFiber->joiners);
+
     // Add ourselves to the list of free fibers
     queue_fiber(currentFiber, &fiberPool);
     
@@ -556,11 +1406,42 @@ void release_fiber(void)
     schedule();   
 }
 
+#if MICROBIT_FIBER_LOCAL_SLOTS > 0
+/**
+  * Allocates a fiber local storage slot.
+  * Every fiber has its own value for the slot, which is NULL until set using fiber_local_set().
+  * Fibers forked on block start with all their slots NULL.
+  *
+  * @param destructor A function to call with the value of the slot when a fiber completes (optional).
+  * It is only called if the value is not NULL.
+  * @return The index of the slot allocated, or MICROBIT_NO_RESOURCES if all MICROBIT_FIBER_LOCAL_SLOTS are in use.
+  */
+int fiber_local_alloc(void (*destructor)(void *))
+{
+    int slot;
+
+    __disable_irq();
+
+    if (fiberLocalSlots >= MICROBIT_FIBER_LOCAL_SLOTS)
+    {
+        __enable_irq();
+        return MICROBIT_NO_RESOURCES;
+    }
+
+    slot = fiberLocalSlots++;
+    fiberLocalDestructors[slot] = destructor;
+
+    __enable_irq();
+
+    return slot;
+}
+#endif
+
 /**
   * Resizes the stack allocation of the current fiber if necessary to hold the system stack.
   *
   * If the stack allocaiton is large enough to hold the current system stack, then this function does nothing.
-  * Otherwise, the the current allocation of the fiber is freed, and a larger block is allocated.
+  * Otherwise, the the current allocation of the fiber is released, and a larger block is allocated.
   *
   * @param f The fiber context to verify.
   */
@@ -571,23 +1452,24 @@ void verify_stack_size(Fiber *f)
     uint32_t bufferSize;
 
     // Calculate the stack depth.
-    stackDepth = f->tcb.stack_base - ((uint32_t) __get_MSP());
+    stackDepth = f->tcb.stack_base - ((PROCESSOR_WORD_TYPE) __get_MSP());
 
     // Calculate the size of our allocated stack buffer 
     bufferSize = f->stack_top - f->stack_bottom;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    if (stackDepth > f->max_stack_depth)
+        f->max_stack_depth = stackDepth;
+#endif
+
     // If we're too small, increase our buffer size.
     if (bufferSize < stackDepth)
     {
-        // To ease heap churn, we choose the next largest multple of 32 bytes.
-        bufferSize = (stackDepth + 32) & 0xffffffe0;
-
         // Release the old memory
-        if (f->stack_bottom != 0)
-            free((void *)f->stack_bottom);
+        release_stack_buffer(f->stack_bottom, bufferSize);
 
         // Allocate a new one of the appropriate size.
-        f->stack_bottom = (uint32_t) malloc(bufferSize);
+        f->stack_bottom = allocate_stack_buffer(stackDepth, &bufferSize);
 
         // Recalculate where the top of the stack is and we're done.
         f->stack_top = f->stack_bottom + bufferSize;
@@ -600,7 +1482,132 @@ void verify_stack_size(Fiber *f)
   */
 int scheduler_runqueue_empty()
 {
-    return (runQueue == NULL);
+    for (int i = 0; i < MICROBIT_FIBER_PRIORITY_LEVELS; i++)
+        if (runQueue[i] != NULL)
+            return 0;
+
+    return 1;
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+/**
+  * Provides statistics on the cost of fork on block.
+  * The number of functions that completed inline is invocations - forks.
+  * @return The statistics gathered since power on.
+  */
+const FiberInvokeStatistics *fiber_invoke_statistics()
+{
+    return &invokeStatistics;
+}
+
+/**
+  * Provides access to every fiber known to the scheduler, whatever its state.
+  * Subsequent fibers can be found by following the list_next field of each fiber.
+  *
+  * @return The first fiber in the list.
+  */
+Fiber *fiber_list()
+{
+    return fiberList;
+}
+#endif
+
+/**
+  * Determines the current state of the given fiber.
+  * @param f The fiber to inspect.
+  * @return One of MICROBIT_FIBER_STATE_RUNNING, MICROBIT_FIBER_STATE_RUNNABLE, MICROBIT_FIBER_STATE_SLEEPING,
+  * MICROBIT_FIBER_STATE_WAITING, MICROBIT_FIBER_STATE_POOLED or MICROBIT_FIBER_STATE_IDLE.
+  */
+int fiber_state(Fiber *f)
+{
+    if (f == currentFiber)
+        return MICROBIT_FIBER_STATE_RUNNING;
+
+    if (f == idleFiber)
+        return MICROBIT_FIBER_STATE_IDLE;
+
+    if (is_runnable_fiber(f))
+        return MICROBIT_FIBER_STATE_RUNNABLE;
+
+    if (f->queue == &sleepQueue)
+        return MICROBIT_FIBER_STATE_SLEEPING;
+
+    if (f->queue == &fiberPool)
+        return MICROBIT_FIBER_STATE_POOLED;
+
+    return MICROBIT_FIBER_STATE_WAITING;
+}
+
+/**
+  * Defers a function call until the idle fiber next runs, before any idle components are serviced.
+  * This allows interrupt handlers to hand off work in a handful of cycles, without using the heap
+  * or the message bus. Safe to call from interrupt context.
+  *
+  * Deferred functions should not block: one that does is moved onto a fiber of its own (see invoke()),
+  * and completes after any calls deferred after it.
+  *
+  * @param fn The function to call.
+  * @param arg The parameter to pass to the function.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL, or MICROBIT_NO_RESOURCES
+  * if MICROBIT_DEFERRED_CALL_QUEUE_SIZE calls are already waiting.
+  */
+int scheduler_defer(void (*fn)(void *), void *arg)
+{
+    FiberDeferredCall *c;
+
+    if (fn == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    __disable_irq();
+
+    if (deferredLength >= MICROBIT_DEFERRED_CALL_QUEUE_SIZE)
+    {
+        __enable_irq();
+        return MICROBIT_NO_RESOURCES;
+    }
+
+    c = &deferredCalls[(deferredHead + deferredLength) % MICROBIT_DEFERRED_CALL_QUEUE_SIZE];
+    c->fn = fn;
+    c->arg = arg;
+    deferredLength++;
+
+    // Prioritise the idle fiber, so the call is run promptly.
+    fiber_flags |= MICROBIT_FLAG_DATA_READY;
+
+    __enable_irq();
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Runs all function calls deferred using scheduler_defer(), in the order in which they were deferred.
+  * Normally called by the idle fiber.
+  * Each call is made using invoke(), so that one that blocks does not block the caller.
+  *
+  * @return The number of calls run.
+  */
+int scheduler_run_deferred()
+{
+    FiberDeferredCall c;
+    int calls = 0;
+
+    while (deferredLength)
+    {
+        // Take a copy of the call, so the slot can be reused as soon as possible.
+        __disable_irq();
+
+        c = deferredCalls[deferredHead];
+        deferredHead = (deferredHead + 1) % MICROBIT_DEFERRED_CALL_QUEUE_SIZE;
+        deferredLength--;
+
+        __enable_irq();
+
+        // We're running on the idle fiber, which must never block. So if the call does, fork it onto a fiber of its own.
+        invoke(c.fn, c.arg);
+        calls++;
+    }
+
+    return calls;
 }
 
 /**
@@ -613,6 +1620,11 @@ void schedule()
     // First, take a reference to the currently running fiber;
     Fiber *oldFiber = currentFiber;
 
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+    // Whichever fiber runs next, it starts with a full budget.
+    watchdog_restart();
+#endif
+
     // First, see if we're in Fork on Block context. If so, we simply want to store the full context
     // of the currently running thread in a newly created fiber, and restore the context of the
     // currently running fiber, back to the point where it entered FOB.
@@ -623,12 +1635,34 @@ void schedule()
         currentFiber->flags |= MICROBIT_FIBER_FLAG_PARENT;
         forkedFiber->flags |= MICROBIT_FIBER_FLAG_CHILD;
 
+        // The forked fiber continues the work of the current one, so give it the same priority.
+        forkedFiber->priority = currentFiber->priority;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        currentFiber->forks++;
+#endif
+
         // Define the stack base of the forked fiber to be align with the entry point of the parent fiber
         forkedFiber->tcb.stack_base = currentFiber->tcb.SP;
 
+#if CONFIG_ENABLED(MICROBIT_HOST)
+        forkedFiber->tcb.stack_base += MICROBIT_HOST_FORK_STACK_MARGIN;
+#endif
+
         // Ensure the stack allocation of the new fiber is large enough 
         verify_stack_size(forkedFiber);
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        // Record the cost of this fork, as the stack between here and the entry point of the fiber is about to be copied.
+        uint32_t forkBytes = forkedFiber->tcb.stack_base - ((PROCESSOR_WORD_TYPE) __get_MSP());
+
+        invokeStatistics.forks++;
+        invokeStatistics.fork_bytes += forkBytes;
+
+        if (forkBytes > invokeStatistics.max_fork_bytes)
+            invokeStatistics.max_fork_bytes = forkBytes;
+#endif
+
         // Store the full context of this fiber.    
         save_context(&forkedFiber->tcb, forkedFiber->stack_top);
 
@@ -643,18 +1677,28 @@ void schedule()
         return; 
     }
 
-    // We're in a normal scheduling context, so perform a round robin algorithm across runnable fibers.
+    // We're in a normal scheduling context, so select the highest priority run queue with work to do,
+    // and perform a round robin algorithm across the runnable fibers on it.
+    // If there's data waiting to be processed, we'll be running the IDLE task whatever the run queues hold.
+    Fiber **queue = (fiber_flags & MICROBIT_FLAG_DATA_READY) ? NULL : select_run_queue();
+
     // OK - if we've nothing to do, then run the IDLE task (power saving sleep)
-    if (runQueue == NULL || fiber_flags & MICROBIT_FLAG_DATA_READY)
+    if (queue == NULL)
         currentFiber = idleFiber;
 
-    else if (currentFiber->queue == &runQueue)
-        // If the current fiber is on the run queue, round robin.
-        currentFiber = currentFiber->next == NULL ? runQueue : currentFiber->next;
+#if CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+    else if ((*queue)->deadline != 0)
+        // The fiber with the earliest deadline is always at the head of the queue.
+        currentFiber = *queue;
+#endif
+
+    else if (currentFiber->queue == queue)
+        // If the current fiber is on the selected run queue, round robin.
+        currentFiber = currentFiber->next == NULL ? *queue : currentFiber->next;
 
     else
-        // Otherwise, just pick the head of the run queue.
-        currentFiber = runQueue;
+        // Otherwise, just pick the head of the selected run queue.
+        currentFiber = *queue;
         
     if (currentFiber == idleFiber && oldFiber->flags & MICROBIT_FIBER_FLAG_DO_NOT_PAGE)
     {
@@ -665,15 +1709,28 @@ void schedule()
         // as we are running on top of this fiber's stack.
         currentFiber = oldFiber;
 
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        // Don't count time spent idling against the fiber whose stack we're borrowing.
+        oldFiber->run_time += ticks - scheduledTime;
+#endif
+
         do
         {
             idle();
         }
-        while (runQueue == NULL || fiber_flags & MICROBIT_FLAG_DATA_READY);
+        while (scheduler_runqueue_empty() || fiber_flags & MICROBIT_FLAG_DATA_READY);
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        scheduledTime = ticks;
+#endif
+
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+        watchdog_restart();
+#endif
 
         // Switch to a non-idle fiber.
         // If this fiber is the same as the old one then there'll be no switching at all.
-        currentFiber = runQueue;
+        currentFiber = *select_run_queue();
     }
 
     // Swap to the context of the chosen fiber, and we're done.
@@ -684,13 +1741,38 @@ void schedule()
         if (currentFiber == idleFiber)
         {
             idleFiber->tcb.SP = CORTEX_M0_STACK_BASE - 0x04;    
-            idleFiber->tcb.LR = (uint32_t) &idle_task;
+            idleFiber->tcb.LR = (PROCESSOR_WORD_TYPE) &idle_task;
+        }
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        // Record the time the old fiber spent running, and that the new one is now running.
+        oldFiber->run_time += ticks - scheduledTime;
+        currentFiber->switches++;
+        scheduledTime = ticks;
+
+        // Fibers with a dedicated stack are never paged out, so measure their stack depth in place.
+        if (oldFiber->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK)
+        {
+            uint32_t stackDepth = oldFiber->stack_top - ((PROCESSOR_WORD_TYPE) __get_MSP());
+
+            if (stackDepth > oldFiber->max_stack_depth)
+                oldFiber->max_stack_depth = stackDepth;
         }
+#endif
+
+        // Fibers with a dedicated stack execute in place, so there's no need to page their stack in or out.
+        PROCESSOR_WORD_TYPE newStack = (currentFiber->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK) ? 0 : currentFiber->stack_top;
 
         if (oldFiber == idleFiber)
         {
             // Just swap in the new fiber, and discard changes to stack and register context.
-            swap_context(NULL, &currentFiber->tcb, 0, currentFiber->stack_top);
+            swap_context(NULL, &currentFiber->tcb, 0, newStack);
+        }
+        else if (oldFiber->flags & MICROBIT_FIBER_FLAG_DEDICATED_STACK || oldFiber->queue == &fiberPool)
+        {
+            // Schedule in the new fiber, just saving the register context of the old one.
+            // The stack of a fiber that has been released is of no further use, so there's no need to page it out either.
+            swap_context(&oldFiber->tcb, &currentFiber->tcb, 0, newStack);
         }
         else
         {
@@ -698,7 +1780,7 @@ void schedule()
             verify_stack_size(oldFiber);
 
             // Schedule in the new fiber.
-            swap_context(&oldFiber->tcb, &currentFiber->tcb, oldFiber->stack_top, currentFiber->stack_top);
+            swap_context(&oldFiber->tcb, &currentFiber->tcb, oldFiber->stack_top, newStack);
         }
     }
 }
@@ -710,16 +1792,40 @@ void schedule()
   */
 void idle()
 {
-    // Service background tasks
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+    // Background tasks (including event handlers) get a full budget of their own.
+    watchdog_restart();
+#endif
+
+    // Run any work handed off by interrupt handlers, then service background tasks
+    scheduler_run_deferred();
     uBit.systemTasks();
 
+    // If more work was deferred in the meantime, make sure we come straight back for it.
+    if (deferredLength)
+        fiber_flags |= MICROBIT_FLAG_DATA_READY;
+
     // If the above did create any useful work, enter power efficient sleep.
-    if(scheduler_runqueue_empty())
+    if(scheduler_runqueue_empty() && !deferredLength)
     {
-        if (uBit.ble)
-            uBit.ble->waitForEvent();
-        else
-            __WFI();
+#if MICROBIT_FIBER_WATCHDOG_MS > 0
+        // Sleeping isn't hogging the processor, so don't let time spent asleep count against the budget.
+        watchdogArmed = 0;
+#endif
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+        // Try to sleep without the system tick until the next fiber is due to wake.
+        if (scheduler_tickless_sleep())
+            return;
+#endif
+        // Hold off interrupts whilst we check that there's still nothing to do, so that one arriving before we sleep
+        // wakes us straight away, rather than being serviced first and then slept through.
+        __disable_irq();
+
+        if (scheduler_runqueue_empty() && !deferredLength && !(fiber_flags & MICROBIT_FLAG_DATA_READY))
+            uBit.systemWait();
+
+        __enable_irq();
     }
 }
 /**
@@ -0,0 +1,219 @@
+/**
+  * Synchronisation primitives for fibers.
+  *
+  * Each primitive parks blocked fibers on its own wait queue using fiber_wait_on(), and wakes them
+  * directly using fiber_wake_one() / fiber_wake_all(), so hand off costs a single context switch
+  * and never touches the message bus.
+  */
+
+#include "MicroBit.h"
+
+/**
+  * Constructor.
+  * Creates a new, unlocked mutex.
+  */
+FiberMutex::FiberMutex()
+{
+    owner = NULL;
+    waitQueue = NULL;
+}
+
+/**
+  * Acquires the lock, blocking the calling fiber until it is available.
+  */
+void FiberMutex::lock()
+{
+    // A handler run by invoke() may yet block and move onto a forked fiber, which would then be unable to release
+    // the lock. So fork now, and take the lock in the fiber that will go on to release it.
+    if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
+        fiber_sleep(0);
+
+    if (owner == NULL)
+    {
+        owner = currentFiber;
+        return;
+    }
+
+    // Block until the lock is handed to us by unlock().
+    fiber_wait_on(&waitQueue);
+}
+
+/**
+  * Attempts to acquire the lock, without blocking.
+  * If called from a handler run by invoke(), the handler is first forked onto its own fiber, as lock() does.
+  * @return MICROBIT_OK if the lock was acquired, or MICROBIT_BUSY if it is held by another fiber.
+  */
+int FiberMutex::tryLock()
+{
+    if (currentFiber->flags & MICROBIT_FIBER_FLAG_FOB)
+        fiber_sleep(0);
+
+    if (owner != NULL)
+        return MICROBIT_BUSY;
+
+    owner = currentFiber;
+    return MICROBIT_OK;
+}
+
+/**
+  * Releases the lock. If any fibers are waiting, ownership passes directly to the first of them.
+  * @return MICROBIT_OK on success, or MICROBIT_NOT_SUPPORTED if the lock is not held by the calling fiber.
+  */
+int FiberMutex::unlock()
+{
+    if (owner != currentFiber)
+        return MICROBIT_NOT_SUPPORTED;
+
+    // Hand the lock straight to the next waiter, so it never has to contend for it again.
+    owner = fiber_wake_one(&waitQueue);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Determines if the lock is currently held.
+  * @return 1 if the lock is held, 0 otherwise.
+  */
+int FiberMutex::isLocked()
+{
+    return owner != NULL;
+}
+
+/**
+  * Constructor.
+  * @param initial The number of permits initially available (defaults to 0).
+  */
+FiberSemaphore::FiberSemaphore(int initial)
+{
+    count = initial;
+    waitQueue = NULL;
+}
+
+/**
+  * Takes a permit, blocking the calling fiber until one is available.
+  */
+void FiberSemaphore::wait()
+{
+    if (count > 0)
+    {
+        count--;
+        return;
+    }
+
+    // Block until a permit is handed to us by signal().
+    fiber_wait_on(&waitQueue);
+}
+
+/**
+  * Attempts to take a permit, without blocking.
+  * @return MICROBIT_OK if a permit was taken, or MICROBIT_BUSY if none are available.
+  */
+int FiberSemaphore::tryWait()
+{
+    if (count <= 0)
+        return MICROBIT_BUSY;
+
+    count--;
+    return MICROBIT_OK;
+}
+
+/**
+  * Releases a permit. If any fibers are waiting, the permit passes directly to the first of them.
+  */
+void FiberSemaphore::signal()
+{
+    if (fiber_wake_one(&waitQueue) == NULL)
+        count++;
+}
+
+/**
+  * Determines the number of permits currently available.
+  * @return The number of permits available.
+  */
+int FiberSemaphore::getCount()
+{
+    return count;
+}
+
+/**
+  * Constructor.
+  */
+FiberConditionVariable::FiberConditionVariable()
+{
+    waitQueue = NULL;
+}
+
+/**
+  * Atomically releases the given mutex and blocks the calling fiber until the condition is notified.
+  * The mutex is reacquired before this call returns.
+  *
+  * @param m The mutex protecting the condition, which must be held by the calling fiber.
+  */
+void FiberConditionVariable::wait(FiberMutex &m)
+{
+    // Fibers are cooperatively scheduled, so nothing can run between releasing the mutex and blocking.
+    m.unlock();
+    fiber_wait_on(&waitQueue);
+    m.lock();
+}
+
+/**
+  * Wakes the first fiber waiting on this condition, if any.
+  */
+void FiberConditionVariable::notifyOne()
+{
+    fiber_wake_one(&waitQueue);
+}
+
+/**
+  * Wakes every fiber waiting on this condition.
+  */
+void FiberConditionVariable::notifyAll()
+{
+    fiber_wake_all(&waitQueue);
+}
+
+/**
+  * Constructor.
+  * Creates a handle that refers to no fiber. Joining such a handle returns immediately.
+  */
+FiberHandle::FiberHandle()
+{
+    fiber = NULL;
+    generation = 0;
+}
+
+/**
+  * Constructor.
+  * Creates a handle to the given fiber, as returned by create_fiber().
+  *
+  * @param f The fiber to refer to.
+  */
+FiberHandle::FiberHandle(Fiber *f)
+{
+    fiber = f;
+    generation = f ? f->generation : 0;
+}
+
+/**
+  * Blocks the calling fiber until the referenced fiber completes.
+  * Returns immediately if it has already completed.
+  *
+  * @return MICROBIT_OK once the fiber has completed, or MICROBIT_INVALID_PARAMETER if the calling fiber attempts to join itself.
+  */
+int FiberHandle::join()
+{
+    if (fiber == NULL)
+        return MICROBIT_OK;
+
+    return fiber_join(fiber, generation);
+}
+
+/**
+  * Determines if the referenced fiber is still running.
+  * @return 1 if the fiber has yet to complete, 0 otherwise.
+  */
+int FiberHandle::isRunning()
+{
+    return fiber != NULL && fiber->generation == generation;
+}
@@ -8,6 +8,10 @@
 #include "mbed.h"
 #include "MicroBit.h"
 
+#if MESSAGE_BUS_LISTENER_POOL_CHUNK > 0
+void *listenerPool = NULL;                  // Unused listeners, just waiting to be registered.
+#endif
+
 /**
   * Constructor. 
   * Create a new Message Bus Listener.
@@ -20,10 +24,18 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
 	this->id = id;
 	this->value = value;
 	this->cb = handler;
+    this->cb_method = NULL;
 	this->cb_arg = NULL;
     this->flags = flags;
 	this->next = NULL;
     this->evt_queue = NULL;
+    this->interval = 0;
+    this->state = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    this->inline_count = 0;
+    this->fork_count = 0;
+#endif
 }
 
 /**
@@ -39,10 +51,45 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
 	this->id = id;
 	this->value = value;
 	this->cb_param = handler;
+    this->cb_method = NULL;
 	this->cb_arg = arg;
     this->flags = flags | MESSAGE_BUS_LISTENER_PARAMETERISED;
 	this->next = NULL;
     this->evt_queue = NULL;
+    this->interval = 0;
+    this->state = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    this->inline_count = 0;
+    this->fork_count = 0;
+#endif
+}
+
+/**
+  * Constructor. 
+  * Create a new Message Bus Listener, that receives events in batches.
+  * @param id The ID of the component you want to listen to.
+  * @param value The event ID you would like to listen to from that component.
+  * @param handler A function pointer to call with the pending events, once the event queue has been drained.
+  * @param arg An additional argument to pass to the event handler function.
+  */
+MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(MicroBitEvent *, int, void *), void* arg, uint16_t flags)
+{
+	this->id = id;
+	this->value = value;
+	this->cb_batch = handler;
+    this->cb_method = NULL;
+	this->cb_arg = arg;
+    this->flags = (flags | MESSAGE_BUS_LISTENER_BATCH) & ~(MESSAGE_BUS_LISTENER_URGENT | MESSAGE_BUS_LISTENER_DEDICATED_FIBER);
+	this->next = NULL;
+    this->evt_queue = NULL;
+    this->interval = 0;
+    this->state = NULL;
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+    this->inline_count = 0;
+    this->fork_count = 0;
+#endif
 }
 
 /**
@@ -50,12 +97,86 @@ MicroBitListener::MicroBitListener(uint16_t id, uint16_t value, void (*handler)(
  */
 MicroBitListener::~MicroBitListener()
 {
-    if(this->flags & MESSAGE_BUS_LISTENER_METHOD)
-        delete cb_method;
+    delete state;
+}
+
+/**
+  * Constructor.
+  * @param batched Allocate a buffer to hold a batch of events, if non-zero.
+  */
+MicroBitListenerState::MicroBitListenerState(int batched)
+{
+    this->batch = batched ? new MicroBitEvent[MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH] : NULL;
+    this->batch_length = 0;
+    this->deadline = 0;
+    this->fiber = NULL;
+}
+
+/**
+  * Destructor. Frees the batch buffer, if any.
+  */
+MicroBitListenerState::~MicroBitListenerState()
+{
+    delete[] batch;
 }
 
+#if MESSAGE_BUS_LISTENER_POOL_CHUNK > 0
+/**
+  * Adds a block of memory to the pool of listeners.
+  * Each free block holds the address of the next in its first word.
+  *
+  * @param block The block to add, which must be at least sizeof(MicroBitListener) bytes.
+  */
+static void listener_pool_push(void *block)
+{
+    *(void **)block = listenerPool;
+    listenerPool = block;
+}
+
+/**
+  * Allocates memory for a listener from the pool of listeners.
+  * Listeners are registered and removed frequently, and are all the same size, so recycling them
+  * is both faster than the general purpose heap and avoids fragmenting it.
+  * The pool is refilled from the heap MESSAGE_BUS_LISTENER_POOL_CHUNK listeners at a time.
+  *
+  * @return The memory, or NULL if the pool is empty and the heap exhausted.
+  */
+void *MicroBitListener::operator new(size_t size) throw()
+{
+    void *block;
+
+    (void)size; /* -Wunused-parameter */
+
+    if (listenerPool == NULL)
+    {
+        uint8_t *chunk = (uint8_t *) malloc(sizeof(MicroBitListener) * MESSAGE_BUS_LISTENER_POOL_CHUNK);
+
+        if (chunk == NULL)
+            return NULL;
+
+        for (int i = 0; i < MESSAGE_BUS_LISTENER_POOL_CHUNK; i++)
+            listener_pool_push(chunk + i * sizeof(MicroBitListener));
+    }
+
+    block = listenerPool;
+    listenerPool = *(void **)block;
+
+    return block;
+}
+
+/**
+  * Returns the memory used by a listener to the pool of listeners.
+  */
+void MicroBitListener::operator delete(void *p)
+{
+    if (p != NULL)
+        listener_pool_push(p);
+}
+#endif
+
 /**
   * Queues and event up to be processed.
+  * If this listener coalesces events, an event already queued with the same ID and value is replaced instead.
   * @param e The event to queue
   */
 void MicroBitListener::queue(MicroBitEvent e)
@@ -70,8 +191,18 @@ void MicroBitListener::queue(MicroBitEvent e)
     {
         queueDepth = 1;
 
-        while (p->next != NULL)
+        while (1)
         {
+            // Only the latest event of each kind is of interest, so update the one we already have.
+            if ((flags & MESSAGE_BUS_LISTENER_COALESCE) && p->evt.source == e.source && p->evt.value == e.value)
+            {
+                p->evt = e;
+                return;
+            }
+
+            if (p->next == NULL)
+                break;
+
             p = p->next;
             queueDepth++;
         }
@@ -12,10 +12,64 @@
   */
 MicroBitMessageBus::MicroBitMessageBus()
 {
-	this->listeners = NULL;
-    this->evt_queue_head = NULL;
-    this->evt_queue_tail = NULL;
+    for (int i = 0; i <= MESSAGE_BUS_LISTENER_BUCKETS; i++)
+        this->listeners[i] = NULL;
+
+    this->evt_queue_head = 0;
     this->queueLength = 0;
+    this->batchPending = 0;
+    this->deferredDeadline = MICROBIT_SYSTEM_TICK_NONE;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    this->traceCount = 0;
+    this->traceDispatched = 0;
+    this->traceSuspended = 0;
+#endif
+
+    for (int i = 0; i < MESSAGE_BUS_PRIORITY_LANES; i++)
+    {
+        this->laneLength[i] = 0;
+        this->laneDequeued[i] = 0;
+    }
+
+    for (int i = 0; i < MESSAGE_BUS_EVENT_POLICIES; i++)
+        this->policies[i].flags = 0;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+    this->resetStatistics();
+#endif
+}
+
+/**
+  * Determines which chain of listeners holds those registered for the given ID.
+  *
+  * @param id The ID of the listener.
+  * @return The index of the chain in the listeners table. Listeners for MICROBIT_ID_ANY are always held in the first.
+  */
+inline int listener_bucket(uint16_t id)
+{
+    return id == MICROBIT_ID_ANY ? 0 : 1 + (id % MESSAGE_BUS_LISTENER_BUCKETS);
+}
+
+/**
+  * Calls the event handler of the given MicroBitListener, with the event stored in the listener.
+  * Determines the calling convention for the callback, and invokes it...
+  */
+void call_listener(MicroBitListener *listener)
+{
+    // C++ is really bad at this! Especially as the ARM compiler is yet to support C++ 11 :-/
+
+    // Firstly, check for a method callback into an object.
+    if (listener->flags & MESSAGE_BUS_LISTENER_METHOD)
+        listener->cb_method->fire(listener->evt);
+
+    // Now a parameterised C function
+    else if (listener->flags & MESSAGE_BUS_LISTENER_PARAMETERISED)
+        listener->cb_param(listener->evt, listener->cb_arg);
+
+    // We must have a plain C function
+    else
+        listener->cb(listener->evt);
 }
 
 /**
@@ -47,25 +101,12 @@ void async_callback(void *param)
         }
     }
 
-    // Determine the calling convention for the callback, and invoke...
-    // C++ is really bad at this! Especially as the ARM compiler is yet to support C++ 11 :-/
-
     // Record that we have a fiber going into this listener...
     listener->flags |= MESSAGE_BUS_LISTENER_BUSY;
 
     while (1)
     {
-        // Firstly, check for a method callback into an object.
-        if (listener->flags & MESSAGE_BUS_LISTENER_METHOD)
-            listener->cb_method->fire(listener->evt);
-
-        // Now a parameterised C function
-        else if (listener->flags & MESSAGE_BUS_LISTENER_PARAMETERISED)
-            listener->cb_param(listener->evt, listener->cb_arg);
-
-        // We must have a plain C function
-        else
-            listener->cb(listener->evt);
+        call_listener(listener);
 
         // If there are more events to process, dequeue the next one and process it.
         if ((listener->flags & MESSAGE_BUS_LISTENER_QUEUE_IF_BUSY) && listener->evt_queue)
@@ -87,17 +128,121 @@ void async_callback(void *param)
     listener->flags &= ~MESSAGE_BUS_LISTENER_BUSY;
 }
 
+/**
+  * Delivers the batch of events gathered by a MicroBitListener registered with MESSAGE_BUS_LISTENER_BATCH.
+  *
+  * Internal wrapper function, used to enable batch callbacks through the fiber scheduler.
+  * Whilst the handler runs, further events are queued on the listener. These are delivered as the next batch.
+  */
+void batch_callback(void *param)
+{
+    MicroBitListener *listener = (MicroBitListener *)param;
+    MicroBitEventQueueItem *item;
+
+    listener->flags |= MESSAGE_BUS_LISTENER_BUSY;
+
+    MicroBitListenerState *state = listener->state;
+
+    while (state->batch_length > 0)
+    {
+        listener->cb_batch(state->batch, state->batch_length, listener->cb_arg);
+        state->batch_length = 0;
+
+        // Gather up anything that arrived whilst the handler was running.
+        while ((item = listener->evt_queue) != NULL && state->batch_length < MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH)
+        {
+            state->batch[state->batch_length++] = item->evt;
+            listener->evt_queue = item->next;
+            delete item;
+        }
+    }
+
+    listener->flags &= ~MESSAGE_BUS_LISTENER_BUSY;
+}
+
+/**
+  * Entry point of the fiber dedicated to a MicroBitListener registered with MESSAGE_BUS_LISTENER_DEDICATED_FIBER.
+  * Handles each event queued on the listener in turn, and waits for more when there are none.
+  * The listener is held BUSY for the lifetime of the fiber, so it can't be deleted from under us.
+  */
+void listener_fiber(void *param)
+{
+    MicroBitListener *listener = (MicroBitListener *)param;
+    MicroBitEventQueueItem *item;
+
+    while (!(listener->flags & MESSAGE_BUS_LISTENER_DELETING))
+    {
+        item = listener->evt_queue;
+
+        // Nothing to do, so wait for the message bus to deliver something.
+        if (item == NULL)
+        {
+            fiber_wait_on(&listener->state->fiber);
+            continue;
+        }
+
+        listener->evt = item->evt;
+        listener->evt_queue = item->next;
+        delete item;
+
+        call_listener(listener);
+    }
+
+    // The listener has been removed. Discard anything left undelivered, and allow the listener to be deleted.
+    while ((item = listener->evt_queue) != NULL)
+    {
+        listener->evt_queue = item->next;
+        delete item;
+    }
+
+    listener->flags &= ~MESSAGE_BUS_LISTENER_BUSY;
+}
+
+/**
+  * Creates the fiber dedicated to the given MicroBitListener.
+  * If there is insufficient memory, the listener reverts to fork on block.
+  *
+  * @param listener The listener.
+  */
+void start_listener_fiber(MicroBitListener *listener)
+{
+    listener->flags |= MESSAGE_BUS_LISTENER_BUSY;
+
+    if (create_fiber(listener_fiber, listener) == NULL)
+        listener->flags &= ~(MESSAGE_BUS_LISTENER_BUSY | MESSAGE_BUS_LISTENER_DEDICATED_FIBER);
+}
+
 /**
   * Queue the given event for processing at a later time.
-  * Add the given event at the tail of our queue.
+  * Add the given event at the tail of its priority lane.
+  *
+  * Events are held by value in a fixed size ring buffer, so this is safe to call from interrupt context
+  * and never touches the heap. The buffer is shared by all lanes, and is held in lane order (highest first),
+  * so the next event to process is always at the head.
   *
-  * @param The event to queue.
+  * @param evt The event to queue.
+  * @param lane The priority lane to queue the event on, or -1 to use the lane given by the event's policy.
   */
-void MicroBitMessageBus::queueEvent(MicroBitEvent &evt)
+void MicroBitMessageBus::queueEvent(MicroBitEvent &evt, int lane)
 {
     int processingComplete;
+    int policy = this->getEventPolicy(evt.source, evt.value);
+
+    if (lane < 0)
+        lane = MESSAGE_BUS_EVENT_GET_LANE(policy);
 
-    MicroBitEventQueueItem *prev = evt_queue_tail;
+    if (lane >= MESSAGE_BUS_PRIORITY_LANES)
+        lane = MESSAGE_BUS_PRIORITY_LANES - 1;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    this->trace(MESSAGE_BUS_TRACE_SEND, evt, us_ticker_read(), 0);
+#endif
+
+    // Record where the tail of our lane is as we enter queueEvent().
+    __disable_irq();
+    uint16_t laneTail = laneLength[lane];
+    uint16_t laneHead = laneDequeued[lane];
+    __enable_irq();
 
     // Now process all handler regsitered as URGENT.
     // These pre-empt the queue, and are useful for fast, high priority services.
@@ -108,65 +253,115 @@ void MicroBitMessageBus::queueEvent(MicroBitEvent &evt)
     if (processingComplete)
         return;
 
-    // If we need to queue, but there is no space, then there's nothg we can do.
+    __disable_irq();
+
+    // If this kind of event is coalesced, and one is already waiting, just bring it up to date.
+    if (policy & MESSAGE_BUS_EVENT_COALESCE)
+    {
+        for (int i = 0; i < queueLength; i++)
+        {
+            MicroBitEvent &e = evt_queue[(evt_queue_head + i) % MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH];
+
+            if (e.source == evt.source && e.value == evt.value)
+            {
+                e = evt;
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+                statistics.coalesced++;
+#endif
+                __enable_irq();
+                return;
+            }
+        }
+    }
+
+    // If the queue is full, make space by dropping the newest event from a lower priority lane, if there is one.
+    // Otherwise, there's nothg we can do.
     if (queueLength >= MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH)
-        return;
+    {
+        int lowest = 0;
+
+        while (laneLength[lowest] == 0)
+            lowest++;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+        statistics.dropped++;
+#endif
+
+        if (lowest >= lane)
+        {
+            __enable_irq();
+            return;
+        }
+
+        laneLength[lowest]--;
+        queueLength--;
+    }
 
     // Otherwise, we need to queue this event for later processing...
-    // We queue this event at the tail of the queue at the point where we entered queueEvent()
+    // We queue this event at the tail of its lane at the point where we entered queueEvent()
     // This is important as the processing above *may* have generated further events, and
     // we want to maintain ordering of events.
-    MicroBitEventQueueItem *item = new MicroBitEventQueueItem(evt);
+    // Allow for any events that have been removed from the head of our lane in the meantime.
+    uint16_t consumed = laneDequeued[lane] - laneHead;
+    uint16_t position = consumed > laneTail ? 0 : laneTail - consumed;
 
-    // The queue was empty when we entered this function, so queue our event at the start of the queue.
-    __disable_irq();
+    if (position > laneLength[lane])
+        position = laneLength[lane];
 
-    if (prev == NULL)
-    {
-        item->next = evt_queue_head;
-        evt_queue_head = item;
-    }
-    else
-    {
-        item->next = prev->next;
-        prev->next = item;
-    }
+    // Our lane follows all those of a higher priority.
+    for (int i = lane + 1; i < MESSAGE_BUS_PRIORITY_LANES; i++)
+        position += laneLength[i];
 
-    if (item->next == NULL)
-        evt_queue_tail = item;
+    // Normally, nothing has been queued since, so no events need to be moved out of the way.
+    for (int i = queueLength; i > position; i--)
+        evt_queue[(evt_queue_head + i) % MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH] = evt_queue[(evt_queue_head + i - 1) % MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH];
 
+    evt_queue[(evt_queue_head + position) % MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH] = evt;
+    laneLength[lane]++;
     queueLength++;
 
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+    statistics.enqueued++;
+
+    if (queueLength > statistics.max_depth)
+        statistics.max_depth = queueLength;
+#endif
+
     __enable_irq();
 }
 
 /**
   * Extract the next event from the front of the event queue (if present).
-  * @return
+  * This is the oldest event on the highest priority lane that has any events.
   *
-  * @param The event to queue.
+  * @param evt Updated with the event removed from the queue.
+  * @return 1 if an event was removed from the queue, 0 if the queue is empty.
   */
-MicroBitEventQueueItem* MicroBitMessageBus::dequeueEvent()
+int MicroBitMessageBus::dequeueEvent(MicroBitEvent &evt)
 {
-    MicroBitEventQueueItem *item = NULL;
+    int dequeued = 0;
 
     __disable_irq();
 
-    if (evt_queue_head != NULL)
+    if (queueLength > 0)
     {
-        item = evt_queue_head;
-        evt_queue_head = item->next;
+        int lane = MESSAGE_BUS_PRIORITY_LANES - 1;
 
-        if (evt_queue_head == NULL)
-            evt_queue_tail = NULL;
+        while (laneLength[lane] == 0)
+            lane--;
 
+        evt = evt_queue[evt_queue_head];
+        evt_queue_head = (evt_queue_head + 1) % MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH;
+        laneLength[lane]--;
+        laneDequeued[lane]++;
         queueLength--;
+
+        dequeued = 1;
     }
 
     __enable_irq();
 
-
-    return item;
+    return dequeued;
 }
 
 /**
@@ -178,31 +373,42 @@ int MicroBitMessageBus::deleteMarkedListeners()
 	MicroBitListener *l, *p;
     int removed = 0;
 
-	l = listeners;
-	p = NULL;
-
-    // Walk this list of event handlers. Delete any that match the given listener.
-    while (l != NULL)
+    for (int i = 0; i <= MESSAGE_BUS_LISTENER_BUCKETS; i++)
     {
-        if (l->flags & MESSAGE_BUS_LISTENER_DELETING && !l->flags & MESSAGE_BUS_LISTENER_BUSY)
+        l = listeners[i];
+        p = NULL;
+
+        // Walk this list of event handlers. Delete any that match the given listener.
+        while (l != NULL)
         {
-            if (p == NULL)
-                listeners = l->next;
-            else
-                p->next = l->next;
+            // Urgent listeners are run from interrupt context, which walks these lists (and may mark a listener BUSY),
+            // so unlink the listener atomically. Once unlinked, it can no longer be reached, and is safe to free.
+            __disable_irq();
 
-            // delete the listener.
-            MicroBitListener *t = l;
-            l = l->next;
+            if ((l->flags & MESSAGE_BUS_LISTENER_DELETING) && !(l->flags & MESSAGE_BUS_LISTENER_BUSY))
+            {
+                if (p == NULL)
+                    listeners[i] = l->next;
+                else
+                    p->next = l->next;
 
-            delete t;
-            removed++;
+                __enable_irq();
 
-            continue;
-        }
+                // delete the listener.
+                MicroBitListener *t = l;
+                l = l->next;
 
-        p = l;
-        l = l->next;
+                delete t;
+                removed++;
+
+                continue;
+            }
+
+            __enable_irq();
+
+            p = l;
+            l = l->next;
+        }
     }
 
     return removed;
@@ -218,35 +424,122 @@ void MicroBitMessageBus::idleTick()
     // Clear out any listeners marked for deletion
     this->deleteMarkedListeners();
 
-    MicroBitEventQueueItem *item = this->dequeueEvent();
+    MicroBitEvent evt;
 
     // Whilst there are events to process and we have no useful other work to do, pull them off the queue and process them.
-    while (item)
+    while (this->dequeueEvent(evt))
     {
-        // send the event to all standard event listeners.
-        this->process(item->evt);
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+        // Record how long the event waited to be processed.
+        unsigned long residency = ticks - evt.timestamp;
+        int bucket = 0;
 
-        // Free the queue item.
-        delete item;
+        while (bucket < MESSAGE_BUS_RESIDENCY_BUCKETS - 1 && residency >= ((unsigned long)FIBER_TICK_PERIOD_MS << bucket))
+            bucket++;
+
+        statistics.residency[bucket]++;
+#endif
+
+        // send the event to all standard event listeners.
+        this->process(evt);
 
         // If we have created some useful work to do, we stop processing.
         // This helps to minimise the number of blocked fibers we create at any point in time, therefore
         // also reducing the RAM footprint.
         if(!scheduler_runqueue_empty())
             break;
+    }
+
+    // Deliver any events held by throttled and debounced listeners that are now due.
+    if (ticks >= deferredDeadline)
+        this->flushDeferred();
+
+    // Deliver any events gathered for batch listeners.
+    if (batchPending)
+        this->flushBatches();
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+    // Let anyone monitoring the bus know we've been dropping events.
+    // We wait until there is space in the queue, so we don't drop our own notification.
+    if (statistics.dropped != droppedReported && queueLength < MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH)
+    {
+        droppedReported = statistics.dropped;
+        MicroBitEvent(MICROBIT_ID_MESSAGE_BUS, MICROBIT_MESSAGE_BUS_EVT_DROPPED);
+    }
+#endif
+}
+
+/**
+  * Delivers the events gathered by every listener that receives events in batches.
+  * Listeners still busy with a previous batch deliver their new events when they complete.
+  */
+void MicroBitMessageBus::flushBatches()
+{
+    batchPending = 0;
+
+    for (int i = 0; i <= MESSAGE_BUS_LISTENER_BUCKETS; i++)
+    {
+        for (MicroBitListener *l = listeners[i]; l != NULL; l = l->next)
+        {
+            if ((l->flags & MESSAGE_BUS_LISTENER_BATCH) && l->state->batch_length > 0 && !(l->flags & (MESSAGE_BUS_LISTENER_BUSY | MESSAGE_BUS_LISTENER_DELETING)))
+                invoke(batch_callback, l);
+        }
+    }
+}
+
+/**
+  * Delivers the events held by throttled and debounced listeners that are now due.
+  * Events held by listeners that have since been removed are discarded.
+  */
+void MicroBitMessageBus::flushDeferred()
+{
+    deferredDeadline = MICROBIT_SYSTEM_TICK_NONE;
+
+    for (int i = 0; i <= MESSAGE_BUS_LISTENER_BUCKETS; i++)
+    {
+        for (MicroBitListener *l = listeners[i]; l != NULL; l = l->next)
+        {
+            if (!(l->flags & MESSAGE_BUS_LISTENER_DEFERRED) || (l->flags & MESSAGE_BUS_LISTENER_DELETING))
+                continue;
+
+            MicroBitListenerState *state = l->state;
+
+            // Not due yet, so just make sure we come back for it.
+            if (ticks < state->deadline)
+            {
+                if (state->deadline < deferredDeadline)
+                    deferredDeadline = state->deadline;
 
-        // Pull the next event to process, if there is one.
-        item = this->dequeueEvent();
+                continue;
+            }
+
+            l->flags &= ~MESSAGE_BUS_LISTENER_DEFERRED;
+
+            // A throttled listener may not receive anything else for another interval.
+            if (l->flags & MESSAGE_BUS_LISTENER_THROTTLE)
+                state->deadline = ticks + l->interval;
+
+            this->deliver(l, state->deferred_evt);
+        }
     }
 }
 
 /**
   * Indicates whether or not we have any background work to do.
-  * @ return 1 if there are any events waitingto be processed, 0 otherwise.
+  * @ return 1 if there are any events waitingto be processed, or held events now due for delivery, 0 otherwise.
   */
 int MicroBitMessageBus::isIdleCallbackNeeded()
 {
-    return !(evt_queue_head == NULL);
+    return queueLength > 0 || ticks >= deferredDeadline;
+}
+
+/**
+  * Determines when we next need attention, so that the system tick can be suspended while the device is idle.
+  * @return The time at which the next event held by a throttled or debounced listener is due, or MICROBIT_SYSTEM_TICK_NONE.
+  */
+unsigned long MicroBitMessageBus::nextSystemTick()
+{
+    return deferredDeadline;
 }
 
 /**
@@ -270,44 +563,144 @@ void MicroBitMessageBus::send(MicroBitEvent evt)
     // We simply queue processing of the event until we're scheduled in normal thread context.
     // We do this to avoid the possibility of executing event handler code in IRQ context, which may bring
     // hidden race conditions to kids code. Queuing all events ensures causal ordering (total ordering in fact).
-    this->queueEvent(evt);
+    this->queueEvent(evt, -1);
 }
 
-/*
- * Deliver the given event to all registered event handlers.
- * Event handlers are called using the invoke() mechanism provided by the fier scheduler
- * This will attempt to call the event handler directly, but spawn a fiber should that
- * event handler attempt a blocking operation.
- * @param evt The event to be delivered.
- * @param urgent The type of listeners to process (optional). If set to true, only listeners defined as urgent and non-blocking will be processed
- * otherwise, all other (standard) listeners will be processed.
- * @return 1 if all matching listeners were processed, 0 if further processing is required.
- */
-int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
+/**
+  * Queues the given event to be sent to all registered recipients, on the given priority lane.
+  * Queued events are processed highest lane first, and in the order they were sent within each lane.
+  *
+  * @param evt The event to send.
+  * @param lane The priority lane to queue the event on, between 0 and MESSAGE_BUS_PRIORITY_LANES - 1.
+  */
+void MicroBitMessageBus::send(MicroBitEvent evt, int lane)
+{
+    if (lane < 0)
+        lane = 0;
+
+    this->queueEvent(evt, lane);
+}
+
+/**
+  * Hands the given event to the event handler of the given listener.
+  *
+  * @param l The listener.
+  * @param evt The event to be delivered.
+  */
+void MicroBitMessageBus::deliver(MicroBitListener *l, MicroBitEvent &evt)
+{
+    l->evt = evt;
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    traceDispatched++;
+#endif
+
+    // OK, if this handler has regisitered itself as non-blocking, we just execute it directly...
+    // This is normally only done for trusted system components.
+    // Otherwise, we invoke it in a 'fork on block' context, that will automatically create a fiber
+    // should the event handler attempt a blocking operation, but doesn't have the overhead
+    // of creating a fiber needlessly. (cool huh?)
+    if (l->flags & MESSAGE_BUS_LISTENER_BATCH)
+    {
+        // Make room in the batch if need be, by delivering what we have so far.
+        if (l->state->batch_length >= MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH && !(l->flags & MESSAGE_BUS_LISTENER_BUSY))
+            invoke(batch_callback, l);
+
+        // The batch can't be changed whilst the handler is using it, so queue the event until it's done.
+        if (l->flags & MESSAGE_BUS_LISTENER_BUSY)
+            l->queue(evt);
+        else
+            l->state->batch[l->state->batch_length++] = evt;
+
+        batchPending = 1;
+    }
+    else if (l->flags & MESSAGE_BUS_LISTENER_DEDICATED_FIBER)
+    {
+        // Listeners known to block have their own fiber, so just hand the event over.
+        l->queue(evt);
+        fiber_wake_one(&l->state->fiber);
+    }
+    else if (l->flags & MESSAGE_BUS_LISTENER_NONBLOCKING)
+    {
+        async_callback(l);
+    }
+    else
+    {
+#if CONFIG_ENABLED(MICROBIT_FIBER_STATISTICS)
+        // Attribute the cost of this invocation to the listener, so that those that
+        // never block can be identified (and marked as MESSAGE_BUS_LISTENER_NONBLOCKING).
+        uint32_t forks = fiber_invoke_statistics()->forks;
+
+        invoke(async_callback, l);
+
+        if (fiber_invoke_statistics()->forks != forks)
+            l->fork_count++;
+        else
+            l->inline_count++;
+#else
+        invoke(async_callback, l);
+#endif
+    }
+}
+
+/**
+  * Determines whether a throttled or debounced listener should receive the given event now, or later.
+  * Throttled listeners receive an event straight away, unless they have received one within the last interval.
+  * Debounced listeners only receive an event once no more have arrived for an interval. Either way, only the
+  * newest event is held, and it is delivered from idleTick() once it is due. Time is measured using the timestamp
+  * of each event, rather than the time at which it is processed.
+  *
+  * @param l The listener.
+  * @param evt The event to be delivered.
+  * @return 1 if the event is being held for later delivery, 0 if it should be delivered now.
+  */
+int MicroBitMessageBus::deferEvent(MicroBitListener *l, MicroBitEvent &evt)
+{
+    MicroBitListenerState *state = l->state;
+
+    if ((l->flags & MESSAGE_BUS_LISTENER_THROTTLE) && !(l->flags & MESSAGE_BUS_LISTENER_DEFERRED) && evt.timestamp >= state->deadline)
+    {
+        state->deadline = evt.timestamp + l->interval;
+        return 0;
+    }
+
+    // Debounced listeners wait for a quiet period after the newest event.
+    if (l->flags & MESSAGE_BUS_LISTENER_DEBOUNCE)
+        state->deadline = evt.timestamp + l->interval;
+
+    state->deferred_evt = evt;
+    l->flags |= MESSAGE_BUS_LISTENER_DEFERRED;
+
+    if (state->deadline < deferredDeadline)
+        deferredDeadline = state->deadline;
+
+    return 1;
+}
+
+/**
+  * Delivers the given event to the matching event handlers on the given chain of listeners.
+  *
+  * @param l The first listener in the chain.
+  * @param evt The event to be delivered.
+  * @param urgent The type of listeners to process. See process().
+  * @return 1 if all matching listeners were processed, 0 if further processing is required.
+  */
+int MicroBitMessageBus::processListeners(MicroBitListener *l, MicroBitEvent &evt, bool urgent)
 {
-	MicroBitListener *l;
     int complete = 1;
     bool listenerUrgent;
 
-    l = listeners;
-    while (l != NULL)
+    // The chain is sorted by ID, so we can stop as soon as we pass the source of the event.
+    while (l != NULL && l->id <= evt.source)
     {
 	    if((l->id == evt.source || l->id == MICROBIT_ID_ANY) && (l->value == evt.value || l->value == MICROBIT_EVT_ANY))
         {
             listenerUrgent = (l->flags & MESSAGE_BUS_LISTENER_IMMEDIATE) == MESSAGE_BUS_LISTENER_IMMEDIATE;
             if(listenerUrgent == urgent && !(l->flags & MESSAGE_BUS_LISTENER_DELETING))
             {
-                l->evt = evt;
-
-                // OK, if this handler has regisitered itself as non-blocking, we just execute it directly...
-                // This is normally only done for trusted system components.
-                // Otherwise, we invoke it in a 'fork on block' context, that will automatically create a fiber
-                // should the event handler attempt a blocking operation, but doesn't have the overhead
-                // of creating a fiber needlessly. (cool huh?)
-                if (l->flags & MESSAGE_BUS_LISTENER_NONBLOCKING)
-                    async_callback(l);
-                else
-                    invoke(async_callback, l);
+                // Throttled and debounced listeners may need to hold on to the event for a while.
+                if (!(l->flags & (MESSAGE_BUS_LISTENER_THROTTLE | MESSAGE_BUS_LISTENER_DEBOUNCE)) || !this->deferEvent(l, evt))
+                    this->deliver(l, evt);
             }
             else
             {
@@ -321,6 +714,40 @@ int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
     return complete;
 }
 
+/*
+ * Deliver the given event to all registered event handlers.
+ * Event handlers are called using the invoke() mechanism provided by the fier scheduler
+ * This will attempt to call the event handler directly, but spawn a fiber should that
+ * event handler attempt a blocking operation.
+ * @param evt The event to be delivered.
+ * @param urgent The type of listeners to process (optional). If set to true, only listeners defined as urgent and non-blocking will be processed
+ * otherwise, all other (standard) listeners will be processed.
+ * @return 1 if all matching listeners were processed, 0 if further processing is required.
+ */
+int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
+{
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    // Handlers may process events of their own, so count our listeners separately from theirs.
+    uint32_t start = us_ticker_read();
+    uint16_t outerDispatched = traceDispatched;
+    traceDispatched = 0;
+#endif
+
+    // Listeners for any ID are processed first, followed by those registered for the source of the event.
+    // This is the order in which they would appear in a single chain sorted by ID.
+    int complete = processListeners(listeners[0], evt, urgent);
+
+    if (evt.source != MICROBIT_ID_ANY)
+        complete &= processListeners(listeners[listener_bucket(evt.source)], evt, urgent);
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+    this->trace(urgent ? MESSAGE_BUS_TRACE_PROCESS_URGENT : MESSAGE_BUS_TRACE_PROCESS, evt, start, traceDispatched);
+    traceDispatched = outerDispatched;
+#endif
+
+    return complete;
+}
+
 /**
   * Register a listener function.
   *
@@ -332,6 +759,11 @@ int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
   *
   * @param handler The function to call when an event is received.
   *
+  * @param flags The MESSAGE_BUS_LISTENER_* options for the listener.
+  *
+  * @param interval The throttle or debounce interval in milliseconds, if MESSAGE_BUS_LISTENER_THROTTLE or
+  * MESSAGE_BUS_LISTENER_DEBOUNCE is given in flags.
+  *
   * @return MICROBIT_OK on success MICROBIT_INVALID_PARAMETER
   *
   * Example:
@@ -344,13 +776,18 @@ int MicroBitMessageBus::process(MicroBitEvent &evt, bool urgent)
   * @endcode
   */
 
-int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags)
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent), uint16_t flags, uint16_t interval)
 {
 	if (handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
 	MicroBitListener *newListener = new MicroBitListener(id, value, handler, flags);
 
+    if (newListener == NULL)
+        return MICROBIT_NO_RESOURCES;
+
+    newListener->interval = interval;
+
     if(add(newListener) == MICROBIT_OK)
         return MICROBIT_OK;
 
@@ -360,13 +797,48 @@ int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent)
 
 }
 
-int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags)
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent, void*), void* arg, uint16_t flags, uint16_t interval)
 {
 	if (handler == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
 	MicroBitListener *newListener = new MicroBitListener(id, value, handler, arg, flags);
 
+    if (newListener == NULL)
+        return MICROBIT_NO_RESOURCES;
+
+    newListener->interval = interval;
+
+    if(add(newListener) == MICROBIT_OK)
+        return MICROBIT_OK;
+
+    delete newListener;
+
+    return MICROBIT_NO_RESOURCES;
+}
+
+/**
+  * Register a listener function that receives events in batches.
+  * Matching events are gathered as the event queue is processed, and delivered in a single call once the
+  * queue has been drained (or up to MESSAGE_BUS_LISTENER_MAX_QUEUE_DEPTH have been gathered).
+  *
+  * @param id The source of messages to listen for. Use MICROBIT_ID_ANY to receive events from all components.
+  * @param value The value of messages to listen for. Use MICROBIT_EVT_ANY to receive events of any value.
+  * @param handler The function to call with the events received, oldest first.
+  * @param arg An additional argument to pass to the handler.
+  *
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER or MICROBIT_NO_RESOURCES.
+  */
+int MicroBitMessageBus::listen(int id, int value, void (*handler)(MicroBitEvent *, int, void *), void* arg, uint16_t flags)
+{
+	if (handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener *newListener = new MicroBitListener(id, value, handler, arg, flags);
+
+    if (newListener == NULL)
+        return MICROBIT_NO_RESOURCES;
+
     if(add(newListener) == MICROBIT_OK)
         return MICROBIT_OK;
 
@@ -437,6 +909,25 @@ int MicroBitMessageBus::ignore(int id, int value, void (*handler)(MicroBitEvent,
 }
 
 
+/**
+ * Unregister a listener function that receives events in batches.
+ * Listners are identified by the Event ID, Event VALUE and handler registered using listen().
+ *
+ * @param id The Event ID used to register the listener.
+ * @param value The Event VALUE used to register the listener.
+ * @param handler The function used to register the listener.
+ */
+int MicroBitMessageBus::ignore(int id, int value, void (*handler)(MicroBitEvent *, int, void *))
+{
+	if (handler == NULL)
+		return MICROBIT_INVALID_PARAMETER;
+
+	MicroBitListener listener(id, value, handler, NULL);
+    remove(&listener);
+
+    return MICROBIT_OK;
+}
+
 /**
   * Add the given MicroBitListener to the list of event handlers, unconditionally.
   * @param listener The MicroBitListener to validate.
@@ -451,7 +942,10 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	if (newListener == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
-	l = listeners;
+    // Listeners are indexed by ID, so only those in the same chain can be affected.
+    MicroBitListener **list = &listeners[listener_bucket(newListener->id)];
+
+	l = *list;
 
 	// Firstly, we treat a listener as an idempotent operation. Ensure we don't already have this handler
 	// registered in a that will already capture these events. If we do, silently ignore.
@@ -468,19 +962,44 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
             // If it's marked for deletion, we simply resurrect the listener, and we're done.
             // Either way, we return an error code, as the *new* listener should be released...
             if(l->flags & MESSAGE_BUS_LISTENER_DELETING)
+            {
                 l->flags &= ~MESSAGE_BUS_LISTENER_DELETING;
 
+                // If the listener's dedicated fiber has already exited, it needs a new one.
+                if ((l->flags & MESSAGE_BUS_LISTENER_DEDICATED_FIBER) && !(l->flags & MESSAGE_BUS_LISTENER_BUSY))
+                    start_listener_fiber(l);
+            }
+
             return MICROBIT_NOT_SUPPORTED;
         }
 
         l = l->next;
     }
 
+    // Throttled and debounced listeners hold on to events, which can't safely be done in interrupt context.
+    // Nor can events be handed to a dedicated fiber there, as that fiber takes them from the listener's queue unguarded.
+    if (newListener->flags & (MESSAGE_BUS_LISTENER_THROTTLE | MESSAGE_BUS_LISTENER_DEBOUNCE | MESSAGE_BUS_LISTENER_DEDICATED_FIBER))
+        newListener->flags &= ~MESSAGE_BUS_LISTENER_URGENT;
+
+    // Listeners that batch, throttle, debounce or have a dedicated fiber need somewhere to keep their state.
+    // Batch listeners also need somewhere to gather their events.
+    if (newListener->flags & MESSAGE_BUS_LISTENER_STATEFUL)
+    {
+        newListener->state = new MicroBitListenerState(newListener->flags & MESSAGE_BUS_LISTENER_BATCH);
+
+        if (newListener->state == NULL || ((newListener->flags & MESSAGE_BUS_LISTENER_BATCH) && newListener->state->batch == NULL))
+            return MICROBIT_NO_RESOURCES;
+    }
+
+    // Listeners pinned to a dedicated fiber need that fiber to be created up front.
+    if (newListener->flags & MESSAGE_BUS_LISTENER_DEDICATED_FIBER)
+        start_listener_fiber(newListener);
+
     // We have a valid, new event handler. Add it to the list.
-	// if listeners is null - we can automatically add this listener to the list at the beginning...
-	if (listeners == NULL)
+	// if the chain is empty - we can automatically add this listener to the list at the beginning...
+	if (*list == NULL)
 	{
-		listeners = newListener;
+		*list = newListener;
 		return MICROBIT_OK;
 	}
 
@@ -489,8 +1008,8 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	// Find the correct point in the chain for this event.
 	// Adding a listener is a rare occurance, so we just walk the list...
 
-	p = listeners;
-	l = listeners;
+	p = *list;
+	l = *list;
 
 	while (l != NULL && l->id < newListener->id)
 	{
@@ -505,12 +1024,12 @@ int MicroBitMessageBus::add(MicroBitListener *newListener)
 	}
 
 	//add at front of list
-	if (p == listeners && (newListener->id < p->id || (p->id == newListener->id && p->value > newListener->value)))
+	if (p == *list && (newListener->id < p->id || (p->id == newListener->id && p->value > newListener->value)))
 	{
 		newListener->next = p;
 
 		//this new listener is now the front!
-		listeners = newListener;
+		*list = newListener;
 	}
 
 	//add after p
@@ -537,26 +1056,38 @@ int MicroBitMessageBus::remove(MicroBitListener *listener)
 	if (listener == NULL)
 		return MICROBIT_INVALID_PARAMETER;
 
-	l = listeners;
+    // A listener for MICROBIT_ID_ANY matches listeners of every ID, so may need to remove listeners from every chain.
+    // Otherwise, only the chain indexed by the given ID can hold a match.
+    int first = listener->id == MICROBIT_ID_ANY ? 0 : listener_bucket(listener->id);
+    int last = listener->id == MICROBIT_ID_ANY ? MESSAGE_BUS_LISTENER_BUCKETS : first;
 
-    // Walk this list of event handlers. Delete any that match the given listener.
-    while (l != NULL)
+    for (int i = first; i <= last; i++)
     {
-        if ((listener->flags & MESSAGE_BUS_LISTENER_METHOD) == (l->flags & MESSAGE_BUS_LISTENER_METHOD))
+        l = listeners[i];
+
+        // Walk this list of event handlers. Delete any that match the given listener.
+        while (l != NULL)
         {
-            if(((listener->flags & MESSAGE_BUS_LISTENER_METHOD) && (*l->cb_method == *listener->cb_method)) ||
-              ((!(listener->flags & MESSAGE_BUS_LISTENER_METHOD) && l->cb == listener->cb)))
+            if ((listener->flags & MESSAGE_BUS_LISTENER_METHOD) == (l->flags & MESSAGE_BUS_LISTENER_METHOD))
             {
-                if ((listener->id == MICROBIT_ID_ANY || listener->id == l->id) && (listener->value == MICROBIT_EVT_ANY || listener->value == l->value))
+                if(((listener->flags & MESSAGE_BUS_LISTENER_METHOD) && (*l->cb_method == *listener->cb_method)) ||
+                  ((!(listener->flags & MESSAGE_BUS_LISTENER_METHOD) && l->cb == listener->cb)))
                 {
-                    // Found a match. mark this to be removed from the list.
-                    l->flags |= MESSAGE_BUS_LISTENER_DELETING;
-                    removed++;
+                    if ((listener->id == MICROBIT_ID_ANY || listener->id == l->id) && (listener->value == MICROBIT_EVT_ANY || listener->value == l->value))
+                    {
+                        // Found a match. mark this to be removed from the list.
+                        l->flags |= MESSAGE_BUS_LISTENER_DELETING;
+                        removed++;
+
+                        // If the listener has its own fiber, wake it so that it can exit.
+                        if (l->flags & MESSAGE_BUS_LISTENER_DEDICATED_FIBER)
+                            fiber_wake_one(&l->state->fiber);
+                    }
                 }
             }
-        }
 
-        l = l->next;
+            l = l->next;
+        }
     }
 
     if (removed > 0)
@@ -565,6 +1096,175 @@ int MicroBitMessageBus::remove(MicroBitListener *listener)
         return MICROBIT_INVALID_PARAMETER;
 }
 
+/**
+  * Sets the policy applied to events with the given ID and value when they are queued.
+  *
+  * @param id The ID of the events to apply the policy to.
+  * @param value The VALUE of the events to apply the policy to. Use MICROBIT_EVT_ANY to apply it to events of any value.
+  * @param flags The policy to apply (e.g. MESSAGE_BUS_EVENT_COALESCE), or 0 to remove any existing policy.
+  * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if MESSAGE_BUS_EVENT_POLICIES are already in use.
+  */
+int MicroBitMessageBus::setEventPolicy(uint16_t id, uint16_t value, uint16_t flags)
+{
+    MicroBitEventPolicy *p = NULL;
+
+    // Reuse any existing entry for this event. Failing that, the first free entry.
+    for (int i = 0; i < MESSAGE_BUS_EVENT_POLICIES; i++)
+    {
+        if (policies[i].flags && policies[i].id == id && policies[i].value == value)
+        {
+            p = &policies[i];
+            break;
+        }
+
+        if (p == NULL && policies[i].flags == 0)
+            p = &policies[i];
+    }
+
+    if (p == NULL)
+        return flags ? MICROBIT_NO_RESOURCES : MICROBIT_OK;
+
+    p->id = id;
+    p->value = value;
+    p->flags = flags;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Determines the policy applied to events with the given ID and value when they are queued.
+  * A policy set for the specific value takes precedence over one set for MICROBIT_EVT_ANY.
+  *
+  * @param id The ID of the event.
+  * @param value The VALUE of the event.
+  * @return The policy flags for the event, or 0 if no policy has been set.
+  */
+int MicroBitMessageBus::getEventPolicy(uint16_t id, uint16_t value)
+{
+    int flags = 0;
+
+    for (int i = 0; i < MESSAGE_BUS_EVENT_POLICIES; i++)
+    {
+        if (policies[i].flags == 0 || policies[i].id != id)
+            continue;
+
+        if (policies[i].value == value)
+            return policies[i].flags;
+
+        if (policies[i].value == MICROBIT_EVT_ANY)
+            flags = policies[i].flags;
+    }
+
+    return flags;
+}
+
+#if CONFIG_ENABLED(MESSAGE_BUS_STATISTICS)
+/**
+  * Provides statistics on the use of the event queue, gathered since power on or the last call to resetStatistics().
+  * @return The event queue statistics.
+  */
+const MicroBitMessageBusStatistics *MicroBitMessageBus::getStatistics()
+{
+    return &statistics;
+}
+
+/**
+  * Clears the event queue statistics.
+  */
+void MicroBitMessageBus::resetStatistics()
+{
+    __disable_irq();
+
+    statistics.enqueued = 0;
+    statistics.dropped = 0;
+    statistics.coalesced = 0;
+    statistics.max_depth = queueLength;
+
+    for (int i = 0; i < MESSAGE_BUS_RESIDENCY_BUCKETS; i++)
+        statistics.residency[i] = 0;
+
+    droppedReported = 0;
+
+    __enable_irq();
+}
+#endif
+
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+/**
+  * Adds a record to the event trace, overwriting the oldest record if the trace is full.
+  * Safe to call from interrupt context.
+  *
+  * @param type The type of record (MESSAGE_BUS_TRACE_*).
+  * @param evt The event.
+  * @param start The time at which the operation started (us).
+  * @param listeners The number of listeners the event was delivered to.
+  */
+void MicroBitMessageBus::trace(uint8_t type, MicroBitEvent &evt, uint32_t start, int listeners)
+{
+    if (traceSuspended)
+        return;
+
+    uint32_t duration = type == MESSAGE_BUS_TRACE_SEND ? 0 : us_ticker_read() - start;
+
+    // Claim the next record. Once claimed, it's ours to fill in.
+    __disable_irq();
+    MicroBitEventTraceRecord *r = &traceRecords[traceCount % MESSAGE_BUS_TRACE_DEPTH];
+    traceCount++;
+    __enable_irq();
+
+    r->timestamp = start;
+    r->source = evt.source;
+    r->value = evt.value;
+    r->duration = duration > 0xFFFF ? 0xFFFF : duration;
+    r->listeners = listeners > 0xFF ? 0xFF : listeners;
+    r->type = type;
+}
+
+/**
+  * Determines how many trace records have been made since power on.
+  * Only the most recent MESSAGE_BUS_TRACE_DEPTH of these are held.
+  *
+  * @return The number of trace records made.
+  */
+uint32_t MicroBitMessageBus::getTraceCount()
+{
+    return traceCount;
+}
+
+/**
+  * Retrieves a record from the event trace.
+  *
+  * @param n The index of the record, where 0 is the oldest record held.
+  * @return The trace record, or NULL if n is out of range.
+  */
+const MicroBitEventTraceRecord *MicroBitMessageBus::getTraceRecord(int n)
+{
+    uint32_t count = traceCount;
+    uint32_t held = count < MESSAGE_BUS_TRACE_DEPTH ? count : MESSAGE_BUS_TRACE_DEPTH;
+
+    if (n < 0 || (uint32_t)n >= held)
+        return NULL;
+
+    return &traceRecords[(count - held + n) % MESSAGE_BUS_TRACE_DEPTH];
+}
+
+/**
+  * Suspends or resumes recording of the event trace, so that it can be read without changing underneath
+  * the reader. Anything that would have been recorded whilst the trace is suspended is discarded.
+  *
+  * @param suspended 1 to suspend recording, 0 to resume it.
+  * @return 1 if recording was suspended before this call, 0 otherwise.
+  */
+int MicroBitMessageBus::suspendTrace(int suspended)
+{
+    int previous = traceSuspended;
+
+    traceSuspended = suspended ? 1 : 0;
+
+    return previous;
+}
+#endif
+
 /**
  * Returns the microBitListener with the given position in our list.
  * @param n The position in the list to return.
@@ -572,18 +1272,22 @@ int MicroBitMessageBus::remove(MicroBitListener *listener)
  */
 MicroBitListener* MicroBitMessageBus::elementAt(int n)
 {
-    MicroBitListener *l = listeners;
-
-    while (n > 0)
+    // Treat the chains as a single list, in index order.
+    for (int i = 0; i <= MESSAGE_BUS_LISTENER_BUCKETS; i++)
     {
-        if (l == NULL)
-            return NULL;
+        MicroBitListener *l = listeners[i];
 
-        n--;
-        l = l->next;
+        while (l != NULL)
+        {
+            if (n == 0)
+                return l;
+
+            n--;
+            l = l->next;
+        }
     }
 
-    return l;
+    return NULL;
 }
 
 /**
@@ -592,4 +1296,8 @@ MicroBitListener* MicroBitMessageBus::elementAt(int n)
 MicroBitMessageBus::~MicroBitMessageBus()
 {
     uBit.removeIdleComponent(this);
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    uBit.removeSystemComponent(this);
+#endif
 }
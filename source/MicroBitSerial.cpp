@@ -143,6 +143,60 @@ void MicroBitSerial::sendDisplayState()
             _putc(uBit.display.image.getPixelValue(j,i));
 }
 
+#if CONFIG_ENABLED(MESSAGE_BUS_TRACE)
+/**
+  * Sends the message bus event trace over serial, in binary.
+  * See MicroBitSerial.h for details of the format.
+  *
+  * Example:
+  * @code 
+  * uBit.serial.sendEventTrace();
+  * @endcode
+  */
+void MicroBitSerial::sendEventTrace()
+{
+    const MicroBitEventTraceRecord *r;
+    int count = 0;
+
+    // Sending the trace takes a while, during which interrupts and other fibers would otherwise keep recording
+    // into it, overwriting records before they're sent. So hold the trace still until we're done.
+    int suspended = uBit.MessageBus.suspendTrace(1);
+
+    while (uBit.MessageBus.getTraceRecord(count) != NULL)
+        count++;
+
+    _putc('M');
+    _putc('B');
+    _putc('T');
+    _putc('R');
+    _putc(1);
+    _putc(sizeof(MicroBitEventTraceRecord));
+    _putc(count & 0xFF);
+    _putc(count >> 8);
+
+    // Records are sent one field at a time, so the output doesn't depend on the layout chosen by the compiler.
+    for (int i = 0; i < count; i++)
+    {
+        if ((r = uBit.MessageBus.getTraceRecord(i)) == NULL)
+            break;
+
+        for (int b = 0; b < 32; b += 8)
+            _putc((r->timestamp >> b) & 0xFF);
+
+        _putc(r->source & 0xFF);
+        _putc(r->source >> 8);
+        _putc(r->value & 0xFF);
+        _putc(r->value >> 8);
+        _putc(r->duration & 0xFF);
+        _putc(r->duration >> 8);
+        _putc(r->listeners);
+        _putc(r->type);
+    }
+
+    uBit.MessageBus.suspendTrace(suspended);
+}
+#endif
+
 /**
   * Reads pixel values, byte-per-pixel, from serial, and sets the display.
   *
@@ -0,0 +1,394 @@
+/**
+  * Class definition for MicroBitTimer.
+  *
+  * Provides one shot and periodic timers that raise events or call functions, without a fiber for each.
+  */
+
+#include "MicroBit.h"
+
+/**
+  * Constructor.
+  * Create a new timer service, and register it for system ticks.
+  * @param id the ID of the new MicroBitTimer object.
+  *
+  * Example:
+  * @code
+  * timer(MICROBIT_ID_TIMER);
+  * @endcode
+  */
+MicroBitTimer::MicroBitTimer(uint16_t id)
+{
+    this->id = id;
+    this->timers = NULL;
+    this->timerCount = 0;
+    this->capacity = 0;
+
+    uBit.addSystemComponent(this);
+}
+
+/**
+  * Raises the given event once, after the given time.
+  *
+  * @param interval The time to wait before raising the event (ms).
+  * @param id The ID of the event to raise.
+  * @param value The VALUE of the event to raise.
+  * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if there is insufficient memory.
+  */
+int MicroBitTimer::eventAfter(unsigned long interval, uint16_t id, uint16_t value)
+{
+    MicroBitTimerEntry timer;
+
+    timer.expiry = ticks + interval;
+    timer.period = 0;
+    timer.fn = NULL;
+    timer.arg = NULL;
+    timer.id = id;
+    timer.value = value;
+
+    return add(timer);
+}
+
+/**
+  * Raises the given event periodically, until the timer is cancelled.
+  *
+  * @param period The time between each event (ms).
+  * @param id The ID of the event to raise.
+  * @param value The VALUE of the event to raise.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if period is 0, or MICROBIT_NO_RESOURCES if
+  * there is insufficient memory.
+  */
+int MicroBitTimer::eventEvery(unsigned long period, uint16_t id, uint16_t value)
+{
+    MicroBitTimerEntry timer;
+
+    if (period == 0)
+        return MICROBIT_INVALID_PARAMETER;
+
+    timer.expiry = ticks + period;
+    timer.period = period;
+    timer.fn = NULL;
+    timer.arg = NULL;
+    timer.id = id;
+    timer.value = value;
+
+    return add(timer);
+}
+
+/**
+  * Calls the given function once, after the given time.
+  * The function is called from the idle thread, and must not block.
+  *
+  * @param interval The time to wait before calling the function (ms).
+  * @param fn The function to call.
+  * @param arg The argument to pass to the function.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL, or MICROBIT_NO_RESOURCES if
+  * there is insufficient memory.
+  */
+int MicroBitTimer::callAfter(unsigned long interval, void (*fn)(void *), void *arg)
+{
+    MicroBitTimerEntry timer;
+
+    if (fn == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    timer.expiry = ticks + interval;
+    timer.period = 0;
+    timer.fn = fn;
+    timer.arg = arg;
+    timer.id = 0;
+    timer.value = 0;
+
+    return add(timer);
+}
+
+/**
+  * Calls the given function periodically, until the timer is cancelled.
+  * The function is called from the idle thread, and must not block.
+  *
+  * @param period The time between each call (ms).
+  * @param fn The function to call.
+  * @param arg The argument to pass to the function.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if fn is NULL or period is 0, or
+  * MICROBIT_NO_RESOURCES if there is insufficient memory.
+  */
+int MicroBitTimer::callEvery(unsigned long period, void (*fn)(void *), void *arg)
+{
+    MicroBitTimerEntry timer;
+
+    if (fn == NULL || period == 0)
+        return MICROBIT_INVALID_PARAMETER;
+
+    timer.expiry = ticks + period;
+    timer.period = period;
+    timer.fn = fn;
+    timer.arg = arg;
+    timer.id = 0;
+    timer.value = 0;
+
+    return add(timer);
+}
+
+/**
+  * Cancels all timers that raise the given event.
+  *
+  * @param id The ID of the event.
+  * @param value The VALUE of the event.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if no such timer was found.
+  */
+int MicroBitTimer::cancel(uint16_t id, uint16_t value)
+{
+    int kept = 0;
+    int removed;
+
+    __disable_irq();
+
+    // Keep only the timers we're not interested in, then put them back into heap order.
+    for (int i = 0; i < timerCount; i++)
+        if (!(timers[i].fn == NULL && timers[i].id == id && timers[i].value == value))
+            timers[kept++] = timers[i];
+
+    removed = timerCount - kept;
+    timerCount = kept;
+
+    if (removed)
+        rebuild();
+
+    __enable_irq();
+
+    return removed ? MICROBIT_OK : MICROBIT_INVALID_PARAMETER;
+}
+
+/**
+  * Cancels all timers that call the given function with the given argument.
+  *
+  * @param fn The function.
+  * @param arg The argument passed to the function.
+  * @return MICROBIT_OK on success, or MICROBIT_INVALID_PARAMETER if no such timer was found.
+  */
+int MicroBitTimer::cancel(void (*fn)(void *), void *arg)
+{
+    int kept = 0;
+    int removed;
+
+    if (fn == NULL)
+        return MICROBIT_INVALID_PARAMETER;
+
+    __disable_irq();
+
+    // Keep only the timers we're not interested in, then put them back into heap order.
+    for (int i = 0; i < timerCount; i++)
+        if (!(timers[i].fn == fn && timers[i].arg == arg))
+            timers[kept++] = timers[i];
+
+    removed = timerCount - kept;
+    timerCount = kept;
+
+    if (removed)
+        rebuild();
+
+    __enable_irq();
+
+    return removed ? MICROBIT_OK : MICROBIT_INVALID_PARAMETER;
+}
+
+/**
+  * Determines the number of active timers.
+  * @return The number of timers that are yet to fire, including all periodic timers.
+  */
+int MicroBitTimer::getTimerCount()
+{
+    return timerCount;
+}
+
+/**
+  * Periodic callback from MicroBit system tick.
+  * Fires any timers that have expired. As the heap is ordered by expiry time, we only need to look
+  * at the top of it to know there is nothing to do.
+  *
+  * Each timer is rescheduled (or removed) before it fires, as the urgent listeners of an event may
+  * themselves add or cancel timers.
+  */
+void MicroBitTimer::systemTick()
+{
+    MicroBitTimerEntry timer;
+
+    while (timerCount > 0 && timers[0].expiry <= ticks)
+    {
+        timer = timers[0];
+
+        // If no more calls can be deferred right now, leave the timer where it is and try again on the next tick.
+        if (timer.fn != NULL && scheduler_defer(timer.fn, timer.arg) != MICROBIT_OK)
+            break;
+
+        if (timer.period > 0)
+        {
+            timers[0].expiry += timer.period;
+
+            // If we've fallen behind (or the period is shorter than a tick), don't try to catch up.
+            if (timers[0].expiry <= ticks)
+                timers[0].expiry = ticks + timer.period;
+
+            siftDown(0);
+        }
+        else
+        {
+            removeAt(0);
+        }
+
+        if (timer.fn == NULL)
+            MicroBitEvent(timer.id, timer.value);
+    }
+}
+
+/**
+  * Determines when we next need to be called, so that the system tick can be suspended while the device is idle.
+  * @return The time at which the next timer expires, or MICROBIT_SYSTEM_TICK_NONE if there are no timers.
+  */
+unsigned long MicroBitTimer::nextSystemTick()
+{
+    return timerCount > 0 ? timers[0].expiry : MICROBIT_SYSTEM_TICK_NONE;
+}
+
+/**
+  * Adds a timer to the heap.
+  * The heap starts with room for MICROBIT_TIMER_INITIAL_CAPACITY timers, and doubles in size whenever it is full.
+  *
+  * @param timer The timer to add.
+  * @return MICROBIT_OK on success, or MICROBIT_NO_RESOURCES if there is insufficient memory.
+  */
+int MicroBitTimer::add(MicroBitTimerEntry &timer)
+{
+    MicroBitTimerEntry *newTimers;
+    MicroBitTimerEntry *oldTimers = NULL;
+
+    if (timerCount >= capacity)
+    {
+        int newCapacity = capacity ? capacity * 2 : MICROBIT_TIMER_INITIAL_CAPACITY;
+
+        if (newCapacity > 0xFFFF)
+            return MICROBIT_NO_RESOURCES;
+
+        newTimers = (MicroBitTimerEntry *) malloc(newCapacity * sizeof(MicroBitTimerEntry));
+
+        if (newTimers == NULL)
+            return MICROBIT_NO_RESOURCES;
+
+        // Timers may fire whilst we copy them, so hold off the system tick.
+        __disable_irq();
+
+        if (timerCount > 0)
+            memcpy(newTimers, timers, timerCount * sizeof(MicroBitTimerEntry));
+
+        oldTimers = timers;
+        timers = newTimers;
+        capacity = newCapacity;
+    }
+    else
+    {
+        __disable_irq();
+    }
+
+    timers[timerCount] = timer;
+    timerCount++;
+    siftUp(timerCount - 1);
+
+    __enable_irq();
+
+    free(oldTimers);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Removes the timer at the given position in the heap, by replacing it with the last timer in the heap.
+  * n.b. Must be called with interrupts disabled (or from the system tick).
+  *
+  * @param n The position of the timer.
+  */
+void MicroBitTimer::removeAt(int n)
+{
+    timerCount--;
+
+    if (n < timerCount)
+    {
+        timers[n] = timers[timerCount];
+
+        siftDown(n);
+        siftUp(n);
+    }
+}
+
+/**
+  * Restores the heap order of every timer, in O(n) time.
+  * n.b. Must be called with interrupts disabled (or from the system tick).
+  */
+void MicroBitTimer::rebuild()
+{
+    for (int i = timerCount / 2 - 1; i >= 0; i--)
+        siftDown(i);
+}
+
+/**
+  * Restores the heap order, by moving the timer at the given position up towards the top.
+  * n.b. Must be called with interrupts disabled (or from the system tick).
+  *
+  * @param n The position of the timer.
+  */
+void MicroBitTimer::siftUp(int n)
+{
+    MicroBitTimerEntry timer = timers[n];
+
+    while (n > 0)
+    {
+        int parent = (n - 1) / 2;
+
+        if (timers[parent].expiry <= timer.expiry)
+            break;
+
+        timers[n] = timers[parent];
+        n = parent;
+    }
+
+    timers[n] = timer;
+}
+
+/**
+  * Restores the heap order, by moving the timer at the given position down towards the bottom.
+  * n.b. Must be called with interrupts disabled (or from the system tick).
+  *
+  * @param n The position of the timer.
+  */
+void MicroBitTimer::siftDown(int n)
+{
+    MicroBitTimerEntry timer = timers[n];
+
+    while (1)
+    {
+        int child = 2 * n + 1;
+
+        if (child >= timerCount)
+            break;
+
+        // Follow whichever child expires first.
+        if (child + 1 < timerCount && timers[child + 1].expiry < timers[child].expiry)
+            child++;
+
+        if (timer.expiry <= timers[child].expiry)
+            break;
+
+        timers[n] = timers[child];
+        n = child;
+    }
+
+    timers[n] = timer;
+}
+
+/**
+  * Destructor for MicroBitTimer, so that we deregister ourselves as a systemComponent.
+  */
+MicroBitTimer::~MicroBitTimer()
+{
+    uBit.removeSystemComponent(this);
+
+    free(timers);
+}
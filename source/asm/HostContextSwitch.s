@@ -0,0 +1,194 @@
+    .text
+    .align 4
+
+# Host (x86-64) implementation of the fiber context switch, for running the scheduler natively on Linux.
+# This mirrors CortexContextSwitch.s, using the same Cortex_M0_TCB layout, with each field widened to 64 bits:
+#
+# RBX, RBP and R12-R15 (the callee saved registers) are stored in the slots for R4-R9.
+# The stack pointer of the caller (i.e. as it will be once we have returned) is stored in SP.
+# The return address is stored in LR.
+# RDI, RSI and RDX are loaded from R0-R2 when a context is restored, so newly created fibers
+# receive their parameters in the same way as on the Cortex M0.
+#
+# All routines use the System V AMD64 calling convention.
+
+    .global swap_context
+    .global save_context
+    .global save_register_context
+    .global restore_register_context
+
+# RDI Contains a pointer to the TCB of the fibre being scheduled out.
+# RSI Contains a pointer to the TCB of the fibre being scheduled in.
+# RDX Contains a pointer to the base of the stack of the fibre being scheduled out.
+# RCX Contains a pointer to the base of the stack of the fibre being scheduled in.
+
+    .type swap_context, @function
+swap_context:
+
+    # Skip this is we're given a NULL parameter for the TCB
+    testq   %rdi, %rdi
+    jz      store_context_complete
+
+    # Write our callee saved registers into the TCB
+    movq    %rbx, 32(%rdi)
+    movq    %rbp, 40(%rdi)
+    movq    %r12, 48(%rdi)
+    movq    %r13, 56(%rdi)
+    movq    %r14, 64(%rdi)
+    movq    %r15, 72(%rdi)
+
+    # Now the Stack and Link Register.
+    leaq    8(%rsp), %rax
+    movq    %rax, 104(%rdi)
+    movq    (%rsp), %rax
+    movq    %rax, 112(%rdi)
+
+store_context_complete:
+    # Finally, Copy the stack.
+    # Skip this is we're given a NULL parameter for the stack.
+    testq   %rdx, %rdx
+    jz      store_stack_complete
+
+    movq    120(%rdi), %r8          # Load R8 with the fiber's defined stack_base.
+    movq    104(%rdi), %r9          # Load R9 with the fiber's stack pointer.
+
+store_stack:
+    subq    $4, %r8
+    subq    $4, %rdx
+
+    movl    (%r8), %eax
+    movl    %eax, (%rdx)
+
+    cmpq    %r9, %r8
+    jne     store_stack
+
+store_stack_complete:
+
+    #
+    # Now page in the new context.
+    #
+    movq    104(%rsi), %rsp
+
+    # Copy the stack in.
+    # n.b. we do this after setting the SP to make comparisons easier.
+
+    # Skip this is we're given a NULL parameter for the stack.
+    testq   %rcx, %rcx
+    jz      restore_stack_complete
+
+    movq    120(%rsi), %r8          # Load R8 with the fiber's defined stack_base.
+
+restore_stack:
+    subq    $4, %r8
+    subq    $4, %rcx
+
+    movl    (%rcx), %eax
+    movl    %eax, (%r8)
+
+    cmpq    %rsp, %r8
+    jne     restore_stack
+
+restore_stack_complete:
+    movq    32(%rsi), %rbx
+    movq    40(%rsi), %rbp
+    movq    48(%rsi), %r12
+    movq    56(%rsi), %r13
+    movq    64(%rsi), %r14
+    movq    72(%rsi), %r15
+
+    movq    0(%rsi), %rdi
+    movq    16(%rsi), %rdx
+    pushq   112(%rsi)
+    movq    8(%rsi), %rsi
+
+    # Return to caller (scheduler).
+    ret
+
+
+# RDI Contains a pointer to the TCB of the fibre to snapshot
+# RSI Contains a pointer to the base of the stack of the fibre being snapshotted
+
+    .type save_context, @function
+save_context:
+
+    # Write our callee saved registers into the TCB
+    movq    %rbx, 32(%rdi)
+    movq    %rbp, 40(%rdi)
+    movq    %r12, 48(%rdi)
+    movq    %r13, 56(%rdi)
+    movq    %r14, 64(%rdi)
+    movq    %r15, 72(%rdi)
+
+    # Now the Stack and Link Register.
+    leaq    8(%rsp), %rax
+    movq    %rax, 104(%rdi)
+    movq    (%rsp), %rax
+    movq    %rax, 112(%rdi)
+
+    # Finally, Copy the stack.
+    movq    120(%rdi), %r8          # Load R8 with the fiber's defined stack_base.
+    movq    104(%rdi), %r9          # Load R9 with the fiber's stack pointer.
+
+store_stack1:
+    subq    $4, %r8
+    subq    $4, %rsi
+
+    movl    (%r8), %eax
+    movl    %eax, (%rsi)
+
+    cmpq    %r9, %r8
+    jne     store_stack1
+
+    # Return to caller (scheduler).
+    ret
+
+
+# RDI Contains a pointer to the TCB of the fiber to snapshot
+
+    .type save_register_context, @function
+save_register_context:
+
+    # Write our callee saved registers into the TCB
+    movq    %rbx, 32(%rdi)
+    movq    %rbp, 40(%rdi)
+    movq    %r12, 48(%rdi)
+    movq    %r13, 56(%rdi)
+    movq    %r14, 64(%rdi)
+    movq    %r15, 72(%rdi)
+
+    # Now the Stack Pointer and Link Register.
+    leaq    8(%rsp), %rax
+    movq    %rax, 104(%rdi)
+    movq    (%rsp), %rax
+    movq    %rax, 112(%rdi)
+
+    # Return to caller (scheduler).
+    ret
+
+
+# RDI Contains a pointer to the TCB of the fiber to restore
+
+    .type restore_register_context, @function
+restore_register_context:
+
+    #
+    # Now page in the new context.
+    #
+    movq    104(%rdi), %rsp
+
+    movq    32(%rdi), %rbx
+    movq    40(%rdi), %rbp
+    movq    48(%rdi), %r12
+    movq    56(%rdi), %r13
+    movq    64(%rdi), %r14
+    movq    72(%rdi), %r15
+
+    movq    8(%rdi), %rsi
+    movq    16(%rdi), %rdx
+    pushq   112(%rdi)
+    movq    0(%rdi), %rdi
+
+    # Return to caller (normally the scheduler).
+    ret
+
+    .section .note.GNU-stack,"",@progbits
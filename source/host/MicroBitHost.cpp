@@ -0,0 +1,166 @@
+/**
+  * Host backend of the micro:bit runtime.
+  *
+  * Provides host equivalents of the Cortex M0 intrinsics used by the runtime, a simulated system stack,
+  * and a periodic simulated interrupt. See MicroBitHost.h.
+  */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "MicroBitHost.h"
+#include "MicroBitFiber.h"
+
+uint32_t microbit_host_stack[MICROBIT_HOST_STACK_SIZE / 4] __attribute__((aligned(16)));   // The simulated system stack.
+char microbit_host_signal_stack[MICROBIT_HOST_SIGNAL_STACK_SIZE];                           // The stack used by simulated interrupts.
+volatile int microbit_host_irq_depth = 0;                                                  // Non-zero whilst a simulated interrupt is being handled.
+volatile uint32_t microbit_host_irq_count = 0;                                             // The number of simulated interrupts handled so far.
+
+void (*microbit_host_tick_handler)(void) = NULL;       // The handler of the simulated periodic interrupt.
+void (*microbit_host_entry)(void) = NULL;              // The function run by microbit_host_start().
+
+/**
+  * Disables simulated interrupts.
+  */
+void __disable_irq()
+{
+    sigset_t s;
+
+    sigemptyset(&s);
+    sigaddset(&s, SIGALRM);
+    sigprocmask(SIG_BLOCK, &s, NULL);
+}
+
+/**
+  * Enables simulated interrupts. Has no effect when called from a simulated interrupt handler.
+  */
+void __enable_irq()
+{
+    sigset_t s;
+
+    // Interrupts can't preempt themselves on the Cortex M0, so don't let the handler be reentered.
+    if (microbit_host_irq_depth)
+        return;
+
+    sigemptyset(&s);
+    sigaddset(&s, SIGALRM);
+    sigprocmask(SIG_UNBLOCK, &s, NULL);
+}
+
+/**
+  * Determines the exception currently being serviced.
+  * @return 15 (SysTick) when called from a simulated interrupt handler, and 0 otherwise.
+  */
+uint32_t __get_IPSR()
+{
+    return microbit_host_irq_depth ? 15 : 0;
+}
+
+/**
+  * Waits for a simulated interrupt.
+  */
+void __WFI()
+{
+    sigset_t none;
+
+    sigemptyset(&none);
+    sigsuspend(&none);
+}
+
+/**
+  * Reads the host's microsecond clock.
+  * @return The time since an arbitrary epoch in microseconds, modulo 2^32.
+  */
+uint32_t us_ticker_read()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint32_t) (t.tv_sec * 1000000ULL + t.tv_nsec / 1000);
+}
+
+/**
+  * SIGALRM handler. Runs the tick handler in simulated interrupt context.
+  */
+void microbit_host_signal(int sig)
+{
+    (void)sig; /* -Wunused-parameter */
+
+    microbit_host_irq_depth++;
+    microbit_host_irq_count++;
+
+    if (microbit_host_tick_handler != NULL)
+        microbit_host_tick_handler();
+
+    microbit_host_irq_depth--;
+}
+
+/**
+  * Configures a simulated periodic interrupt, typically used to drive the scheduler via scheduler_tick().
+  * There is a single simulated timer, so this replaces any interrupt configured previously.
+  *
+  * @param handler The function to call from simulated interrupt context.
+  * @param period_us The period of the interrupt, in microseconds, or 0 for a single interrupt.
+  * @param delay_us The time until the first interrupt, in microseconds, or 0 to wait for a whole period.
+  */
+void microbit_host_attach_tick(void (*handler)(void), uint32_t period_us, uint32_t delay_us)
+{
+    stack_t ss;
+    struct sigaction sa;
+    struct itimerval timer;
+
+    // Handle interrupts on their own stack, so that they never disturb the paged fiber stacks.
+    ss.ss_sp = microbit_host_signal_stack;
+    ss.ss_size = sizeof(microbit_host_signal_stack);
+    ss.ss_flags = 0;
+    sigaltstack(&ss, NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = microbit_host_signal;
+    sa.sa_flags = SA_ONSTACK | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGALRM, &sa, NULL);
+
+    microbit_host_tick_handler = handler;
+
+    if (delay_us == 0)
+        delay_us = period_us;
+
+    timer.it_interval.tv_sec = period_us / 1000000;
+    timer.it_interval.tv_usec = period_us % 1000000;
+    timer.it_value.tv_sec = delay_us / 1000000;
+    timer.it_value.tv_usec = delay_us % 1000000;
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+/**
+  * Entry point on the simulated system stack.
+  */
+void microbit_host_launch()
+{
+    microbit_host_entry();
+    exit(0);
+}
+
+/**
+  * Switches onto the simulated system stack, and calls the given function.
+  * This must be used to run any code that uses the fiber scheduler. The process exits once the function returns.
+  *
+  * @param entry The function to run, typically one that calls scheduler_init() and then the code under test.
+  */
+void microbit_host_start(void (*entry)(void))
+{
+    Cortex_M0_TCB tcb;
+
+    microbit_host_entry = entry;
+
+    memset(&tcb, 0, sizeof(tcb));
+    tcb.SP = CORTEX_M0_STACK_BASE - 0x08;
+    tcb.LR = (uintptr_t) &microbit_host_launch;
+
+    restore_register_context(&tcb);
+}
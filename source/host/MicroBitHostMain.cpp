@@ -0,0 +1,241 @@
+/**
+  * Host equivalent of MicroBit.cpp and MicroBitSuperMain.cpp.
+  *
+  * Defines the host MicroBit device (see host/inc/MicroBit.h), and a main() that brings up the scheduler
+  * on the simulated system stack before handing over to app_main(), just as the device does.
+  */
+
+#include "MicroBit.h"
+
+MicroBit        uBit;
+
+/**
+  * Simulated interrupt handler for the system tick.
+  */
+void microbit_host_system_tick()
+{
+    uBit.systemTick();
+}
+
+/**
+  * Constructor.
+  */
+MicroBit::MicroBit() :
+    flags(0x00),
+    timer(MICROBIT_ID_TIMER)
+{
+}
+
+/**
+  * Starts the simulated system tick, and registers the message bus as an idle component.
+  * Must be called after scheduler_init(), as on the device.
+  */
+void MicroBit::init()
+{
+    addIdleComponent(&MessageBus);
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    // Make sure we wake up in time to deliver events held by throttled and debounced listeners.
+    addSystemComponent(&MessageBus);
+#endif
+
+    microbit_host_attach_tick(microbit_host_system_tick, FIBER_TICK_PERIOD_MS * 1000);
+}
+
+/**
+  * Delay for the given amount of time. Uses the scheduler, so other fibers run in the meantime.
+  * @param milliseconds the amount of time, in ms, to wait for.
+  * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if milliseconds is less than zero.
+  */
+int MicroBit::sleep(int milliseconds)
+{
+    if(milliseconds < 0)
+        return MICROBIT_INVALID_PARAMETER;
+
+    fiber_sleep(milliseconds);
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Periodic callback. Drives the scheduler and the system components, from simulated interrupt context.
+  */
+void MicroBit::systemTick()
+{
+    if (flags & MICROBIT_FLAG_SCHEDULER_RUNNING)
+        scheduler_tick();
+
+    //work out if any idle components need processing, if so prioritise the idle thread
+    for(int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if(idleThreadComponents[i] != NULL && idleThreadComponents[i]->isIdleCallbackNeeded())
+        {
+            fiber_flags |= MICROBIT_FLAG_DATA_READY;
+            break;
+        }
+
+    //update any components in the systemComponents array
+    for(int i = 0; i < MICROBIT_SYSTEM_COMPONENTS; i++)
+        if(systemTickComponents[i] != NULL)
+            systemTickComponents[i]->systemTick();
+}
+
+/**
+  * System tasks to be executed by the idle thread.
+  */
+void MicroBit::systemTasks()
+{
+    for(int i = 0; i < MICROBIT_IDLE_COMPONENTS; i++)
+        if(idleThreadComponents[i] != NULL)
+            idleThreadComponents[i]->idleTick();
+
+    fiber_flags &= ~MICROBIT_FLAG_DATA_READY;
+}
+
+/**
+  * Waits for a simulated interrupt, as MicroBit::systemWait() does on the device.
+  * Called by the idle thread with interrupts disabled, and returns with them disabled.
+  */
+void MicroBit::systemWait()
+{
+    __WFI();
+}
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+/**
+  * Simulated interrupt handler used to wake the processor from tickless idle.
+  * Prioritises the idle thread, so that it doesn't go on to sleep if we're called before it has done so.
+  */
+void microbit_host_system_wake()
+{
+    fiber_flags |= MICROBIT_FLAG_DATA_READY;
+}
+
+/**
+  * Replaces the simulated system tick with a single wake up call, as MicroBit::systemTickSuspend() does on the device.
+  * @param period The time until the wake up call, in microseconds.
+  */
+void MicroBit::systemTickSuspend(uint32_t period)
+{
+    microbit_host_attach_tick(microbit_host_system_wake, 0, period);
+}
+
+/**
+  * Restarts the simulated system tick, as MicroBit::systemTickResume() does on the device.
+  * @param tick If non-zero, a system tick is also delivered straight away (from simulated interrupt context).
+  */
+void MicroBit::systemTickResume(int tick)
+{
+    microbit_host_attach_tick(microbit_host_system_tick, FIBER_TICK_PERIOD_MS * 1000, tick ? 1 : 0);
+}
+#endif
+
+/**
+  * add a component to the array of components which invocate the systemTick member function during a systemTick
+  * @param component The component to add.
+  * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+  */
+int MicroBit::addSystemComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_SYSTEM_COMPONENTS && systemTickComponents[i] != NULL)
+        i++;
+
+    if(i == MICROBIT_SYSTEM_COMPONENTS)
+        return MICROBIT_NO_RESOURCES;
+
+    systemTickComponents[i] = component;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * remove a component from the array of components
+  * @param component The component to remove.
+  * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+  */
+int MicroBit::removeSystemComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_SYSTEM_COMPONENTS && systemTickComponents[i] != component)
+        i++;
+
+    if(i == MICROBIT_SYSTEM_COMPONENTS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    systemTickComponents[i] = NULL;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * add a component to the array of components which invocate the systemTick member function during a systemTick
+  * @param component The component to add.
+  * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+  */
+int MicroBit::addIdleComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_IDLE_COMPONENTS && idleThreadComponents[i] != NULL)
+        i++;
+
+    if(i == MICROBIT_IDLE_COMPONENTS)
+        return MICROBIT_NO_RESOURCES;
+
+    idleThreadComponents[i] = component;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * remove a component from the array of components
+  * @param component The component to remove.
+  * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+  */
+int MicroBit::removeIdleComponent(MicroBitComponent *component)
+{
+    int i = 0;
+
+    while(i < MICROBIT_IDLE_COMPONENTS && idleThreadComponents[i] != component)
+        i++;
+
+    if(i == MICROBIT_IDLE_COMPONENTS)
+        return MICROBIT_INVALID_PARAMETER;
+
+    idleThreadComponents[i] = NULL;
+
+    return MICROBIT_OK;
+}
+
+/**
+  * Determine the time since the scheduler was started.
+  * @return The time in milliseconds.
+  */
+unsigned long MicroBit::systemTime()
+{
+    return ticks;
+}
+
+/**
+  * Runs on the simulated system stack. Brings up the scheduler, then runs the application.
+  */
+void microbit_host_main()
+{
+    // Bring up fiber scheduler
+    scheduler_init();
+
+    // Bring up the system tick.
+    uBit.init();
+
+    app_main();
+}
+
+int main()
+{
+    microbit_host_start(microbit_host_main);
+
+    // We should never get here, as microbit_host_start() exits once app_main() returns.
+    return 1;
+}
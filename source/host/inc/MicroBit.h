@@ -0,0 +1,138 @@
+/**
+  * Host stand in for MicroBit.h.
+  *
+  * Host builds have no display, sensors or radio, so this defines a MicroBit device class that holds just
+  * the message bus and timer service, along with the system and idle component arrays that drive them.
+  * The device is created, and the scheduler started, by host/MicroBitHostMain.cpp.
+  */
+
+#ifndef MICROBIT_H
+#define MICROBIT_H
+
+#include "mbed.h"
+
+#include "MicroBitConfig.h"
+#include "ErrorNo.h"
+#include "MicroBitCompat.h"
+#include "MicroBitComponent.h"
+#include "MicroBitEvent.h"
+
+#include "MicroBitFiber.h"
+#include "MicroBitFiberSync.h"
+#include "MicroBitMessageBus.h"
+#include "MicroBitTimer.h"
+
+// MicroBit::flags values
+#define MICROBIT_FLAG_SCHEDULER_RUNNING         0x00000001
+
+/**
+  * Class definition for a host MicroBit device.
+  */
+class MicroBit
+{
+    public:
+
+    // Map of device state.
+    uint32_t                flags;
+
+    // Array of components which are iterated during a system tick
+    MicroBitComponent*      systemTickComponents[MICROBIT_SYSTEM_COMPONENTS];
+
+    // Array of components which are iterated during idle thread execution, isIdleCallbackNeeded is polled during a systemTick.
+    MicroBitComponent*      idleThreadComponents[MICROBIT_IDLE_COMPONENTS];
+
+    // Message bus
+    MicroBitMessageBus      MessageBus;
+
+    // Timer service
+    MicroBitTimer           timer;
+
+    /**
+      * Constructor.
+      */
+    MicroBit();
+
+    /**
+      * Starts the simulated system tick, and registers the message bus as an idle component.
+      * Must be called after scheduler_init(), as on the device.
+      */
+    void init();
+
+    /**
+      * Delay for the given amount of time. Uses the scheduler, so other fibers run in the meantime.
+      * @param milliseconds the amount of time, in ms, to wait for.
+      * @return MICROBIT_OK on success, MICROBIT_INVALID_PARAMETER if milliseconds is less than zero.
+      */
+    int sleep(int milliseconds);
+
+    /**
+      * Periodic callback. Drives the scheduler and the system components, from simulated interrupt context.
+      */
+    void systemTick();
+
+    /**
+      * System tasks to be executed by the idle thread.
+      */
+    void systemTasks();
+
+    /**
+      * Waits for a simulated interrupt, as MicroBit::systemWait() does on the device.
+      * Called by the idle thread with interrupts disabled, and returns with them disabled.
+      */
+    void systemWait();
+
+#if CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+    /**
+      * Replaces the simulated system tick with a single wake up call, as MicroBit::systemTickSuspend() does on the device.
+      * @param period The time until the wake up call, in microseconds.
+      */
+    void systemTickSuspend(uint32_t period);
+
+    /**
+      * Restarts the simulated system tick, as MicroBit::systemTickResume() does on the device.
+      * @param tick If non-zero, a system tick is also delivered straight away (from simulated interrupt context).
+      */
+    void systemTickResume(int tick);
+#endif
+
+    /**
+      * add a component to the array of components which invocate the systemTick member function during a systemTick
+      * @param component The component to add.
+      * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+      */
+    int addSystemComponent(MicroBitComponent *component);
+
+    /**
+      * remove a component from the array of components
+      * @param component The component to remove.
+      * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+      */
+    int removeSystemComponent(MicroBitComponent *component);
+
+    /**
+      * add a component to the array of components which invocate the systemTick member function during a systemTick
+      * @param component The component to add.
+      * @return MICROBIT_OK on success. MICROBIT_NO_RESOURCES is returned if further components cannot be supported.
+      */
+    int addIdleComponent(MicroBitComponent *component);
+
+    /**
+      * remove a component from the array of components
+      * @param component The component to remove.
+      * @return MICROBIT_OK on success. MICROBIT_INVALID_PARAMTER is returned if the given component has not been previous added.
+      */
+    int removeIdleComponent(MicroBitComponent *component);
+
+    /**
+      * Determine the time since the scheduler was started.
+      * @return The time in milliseconds.
+      */
+    unsigned long systemTime();
+};
+
+// Definition of the global instance of the MicroBit class, and the entry point of the application or test.
+extern MicroBit uBit;
+
+void app_main();
+
+#endif
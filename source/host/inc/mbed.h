@@ -0,0 +1,17 @@
+/**
+  * Minimal stand in for mbed.h, used by host builds of the micro:bit runtime.
+  *
+  * Provides only the standard headers the fiber scheduler, message bus and timer service rely upon.
+  * The Cortex M0 intrinsics are provided by MicroBitHost.h, which host builds force include ahead of this file.
+  */
+
+#ifndef MBED_H
+#define MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#endif
@@ -0,0 +1,277 @@
+/**
+  * Host benchmark of the fiber scheduler and message bus.
+  *
+  * Times the operations whose cost depends on how many fibers or listeners there are, so that changes to the
+  * underlying data structures can be measured. Not run as a test: timings on the host are only meaningful
+  * relative to one another, and vary with the load on the host.
+  *
+  * Some results depend on configuration, so are best compared across builds. For example:
+  * MESSAGE_BUS_LISTENER_POOL_CHUNK=0 (heap allocated listeners), or MESSAGE_BUS_LISTENER_BUCKETS=1 (a single chain
+  * of listeners).
+  */
+
+#include "MicroBit.h"
+#include <time.h>
+
+#define BENCH_ID            8000
+#define BENCH_LISTENER_ID   4000    // Below BENCH_ID, so that lookups never pass the listeners of the fibers waiting on it.
+#define BENCH_REPEATS       200
+
+const int counts[] = {1, 10, 100, 1000};
+const int sleepCounts[] = {1, 10, 50, 200};
+
+int stop;                   // Set to end the fibers created by a benchmark.
+uint64_t woken;             // The time at which the responder last ran (ns).
+Fiber sleeper;              // A fiber context used only to time insertion into the sleep queue.
+uint64_t samples[BENCH_REPEATS];
+
+/**
+  * Determines the time, with more resolution than the system timer offers.
+  * @return The time since an arbitrary epoch, in nanoseconds.
+  */
+uint64_t now()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/**
+  * Determines the median of the samples taken, which discards those disturbed by the simulated system tick.
+  * @param n The number of samples.
+  * @return The median sample.
+  */
+uint64_t median(int n)
+{
+    for (int i = 1; i < n; i++)
+        for (int j = i; j > 0 && samples[j] < samples[j-1]; j--)
+        {
+            uint64_t t = samples[j];
+            samples[j] = samples[j-1];
+            samples[j-1] = t;
+        }
+
+    return samples[n / 2];
+}
+
+void sleepForever(void *param)
+{
+    // Spread the wake up times, so that the sleep queue has to be kept in order.
+    fiber_sleep(100000000 + (int)(intptr_t) param * 10);
+}
+
+void waiter(void *param)
+{
+    while (!stop)
+        fiber_wait_for_event(BENCH_ID, (int)(intptr_t) param);
+}
+
+void spinner()
+{
+    while (!stop)
+        schedule();
+}
+
+void responder()
+{
+    while (!stop)
+    {
+        fiber_wait_for_event(BENCH_ID, 1);
+        woken = now();
+    }
+}
+
+void onEvent(MicroBitEvent)
+{
+}
+
+/**
+  * Times scheduler_tick() and insertion into the sleep queue, with the given number of fibers asleep.
+  */
+void benchSleepQueue(int n)
+{
+    for (int i = 0; i < n; i++)
+        create_fiber(sleepForever, (void *)(intptr_t) i);
+
+    // Let them all go to sleep.
+    uBit.sleep(10);
+
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        // The system tick is normally called from interrupt context, so mustn't be interrupted by another.
+        __disable_irq();
+
+        uint64_t start = now();
+        scheduler_tick();
+        samples[r] = now() - start;
+
+        __enable_irq();
+    }
+
+    uint64_t tick = median(BENCH_REPEATS);
+
+    // Insert a fiber due to wake half way down the queue.
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        sleeper.context = ticks + 100000000 + n * 5;
+
+        uint64_t start = now();
+        queue_sleeping_fiber(&sleeper);
+        samples[r] = now() - start;
+
+        dequeue_fiber(&sleeper);
+    }
+
+    printf("  %4d sleeping: scheduler_tick() %5llu ns, sleep queue insert %5llu ns\n", n,
+        (unsigned long long) tick, (unsigned long long) median(BENCH_REPEATS));
+
+    // Wake everything up, so the next run starts afresh.
+    ticks += 200000000;
+    uBit.sleep(50);
+}
+
+/**
+  * Times raising an event that wakes a single fiber, with the given number of fibers waiting on other values
+  * of the same event ID.
+  */
+void benchWakeByEvent(int n)
+{
+    stop = 0;
+
+    for (int i = 0; i < n; i++)
+        create_fiber(waiter, (void *)(intptr_t)(i + 1));
+
+    uBit.sleep(10);
+
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        uint64_t start = now();
+        MicroBitEvent(BENCH_ID, n / 2 + 1);
+        samples[r] = now() - start;
+
+        // Let the fiber we woke wait again, and the message bus drain its queue.
+        uBit.sleep(1);
+    }
+
+    printf("  %4d waiting: wake by event %5llu ns\n", n, (unsigned long long) median(BENCH_REPEATS));
+
+    stop = 1;
+
+    for (int i = 0; i < n; i++)
+        MicroBitEvent(BENCH_ID, i + 1);
+
+    uBit.sleep(50);
+}
+
+/**
+  * Times delivery of an event to its one listener, with the given number of listeners registered on other IDs.
+  */
+void benchListenerLookup(int n)
+{
+    for (int i = 0; i < n; i++)
+        uBit.MessageBus.listen(BENCH_LISTENER_ID + i, 1, onEvent, MESSAGE_BUS_LISTENER_IMMEDIATE);
+
+    MicroBitEvent evt(BENCH_LISTENER_ID + n / 2, 1, CREATE_ONLY);
+
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        uint64_t start = now();
+        uBit.MessageBus.process(evt, true);
+        samples[r] = now() - start;
+    }
+
+    printf("  %4d listeners: process() %5llu ns\n", n, (unsigned long long) median(BENCH_REPEATS));
+
+    for (int i = 0; i < n; i++)
+        uBit.MessageBus.ignore(BENCH_LISTENER_ID + i, 1, onEvent);
+
+    uBit.sleep(10);
+}
+
+/**
+  * Times registering and removing listeners, as an application that frequently changes its event handlers would.
+  * The listeners are freed by the idle thread, outside the timed section, so only their allocation is timed.
+  */
+void benchListenerChurn()
+{
+    const int n = 16;
+
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        uint64_t start = now();
+
+        for (int i = 0; i < n; i++)
+            uBit.MessageBus.listen(BENCH_LISTENER_ID + i, 1, onEvent);
+
+        for (int i = 0; i < n; i++)
+            uBit.MessageBus.ignore(BENCH_LISTENER_ID + i, 1, onEvent);
+
+        samples[r] = (now() - start) / n;
+
+        // Removed listeners are freed by the idle thread.
+        uBit.sleep(1);
+    }
+
+    printf("  listen() + ignore() %5llu ns per listener\n", (unsigned long long) median(BENCH_REPEATS));
+}
+
+/**
+  * Times how long a fiber woken by an event takes to run, with the given number of other fibers runnable.
+  */
+void benchWakeToRun(int n, int priority)
+{
+    stop = 0;
+
+    for (int i = 0; i < n; i++)
+        create_fiber(spinner, release_fiber, MICROBIT_FIBER_DEFAULT_PRIORITY);
+
+    create_fiber(responder, release_fiber, priority);
+
+    for (int r = 0; r < BENCH_REPEATS; r++)
+    {
+        // Make sure the responder is waiting.
+        schedule();
+
+        uint64_t start = now();
+        MicroBitEvent(BENCH_ID, 1);
+
+        while (woken < start)
+            schedule();
+
+        samples[r] = woken - start;
+    }
+
+    printf("  %4d runnable: wake to run (responder priority %d) %7llu ns\n", n, priority,
+        (unsigned long long) median(BENCH_REPEATS));
+
+    stop = 1;
+    MicroBitEvent(BENCH_ID, 1);
+    uBit.sleep(50);
+}
+
+void app_main()
+{
+    printf("Sleep queue:\n");
+    for (int i = 0; i < 4; i++)
+        benchSleepQueue(sleepCounts[i]);
+
+    printf("Wake by event:\n");
+    for (int i = 0; i < 3; i++)
+        benchWakeByEvent(counts[i]);
+
+    printf("Listener lookup (MESSAGE_BUS_LISTENER_BUCKETS=%d):\n", MESSAGE_BUS_LISTENER_BUCKETS);
+    for (int i = 0; i < 4; i++)
+        benchListenerLookup(counts[i]);
+
+    printf("Listener allocation (MESSAGE_BUS_LISTENER_POOL_CHUNK=%d):\n", MESSAGE_BUS_LISTENER_POOL_CHUNK);
+    benchListenerChurn();
+
+    printf("Wake to run:\n");
+    for (int i = 0; i < 3; i++)
+    {
+        benchWakeToRun(counts[i], MICROBIT_FIBER_DEFAULT_PRIORITY);
+        benchWakeToRun(counts[i], MICROBIT_FIBER_PRIORITY_LEVELS - 1);
+    }
+}
@@ -0,0 +1,76 @@
+/**
+  * Host test of earliest deadline first scheduling.
+  *
+  * Runs two periodic fibers that are released together, and checks that the one with the earlier deadline is
+  * always run first, whichever order they were created or went to sleep in.
+  */
+
+#include "MicroBit.h"
+
+#if !CONFIG_ENABLED(MICROBIT_FIBER_EDF)
+#error "This test requires MICROBIT_FIBER_EDF"
+#endif
+
+#define TEST_RUNS           32
+
+FiberPeriodicTask *tasks[2];            // The slow task (created first), and the fast one (with the earlier deadlines).
+int runTask[TEST_RUNS];                 // The task of each run, in the order they were run.
+unsigned long runRelease[TEST_RUNS];    // The release time of each run.
+int runs = 0;
+
+/**
+  * Reports a failed check, and ends the test.
+  */
+void check(int condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        exit(1);
+    }
+}
+
+void periodic(void *param)
+{
+    int i = (int)(intptr_t) param;
+
+    if (runs < TEST_RUNS)
+    {
+        runTask[runs] = i;
+        runRelease[runs] = tasks[i]->release;
+        runs++;
+    }
+}
+
+void app_main()
+{
+    int together = 0;
+
+    // Start just after a tick, so that both tasks are released at the same time.
+    uBit.sleep(FIBER_TICK_PERIOD_MS);
+
+    tasks[0] = create_periodic_fiber(periodic, (void *) 0, 4 * FIBER_TICK_PERIOD_MS);
+    tasks[1] = create_periodic_fiber(periodic, (void *) 1, 2 * FIBER_TICK_PERIOD_MS);
+
+    check(tasks[0] != NULL && tasks[1] != NULL, "create_periodic_fiber");
+    check(tasks[0]->release == tasks[1]->release, "both tasks are first released together");
+
+    uBit.sleep(12 * FIBER_TICK_PERIOD_MS);
+
+    cancel_periodic_fiber(tasks[0]);
+    cancel_periodic_fiber(tasks[1]);
+
+    // Whenever both tasks are released together, the fast task has the earlier deadline, so must run first.
+    for (int r = 0; r < runs; r++)
+    {
+        if (runTask[r] != 0)
+            continue;
+
+        check(r > 0 && runTask[r-1] == 1 && runRelease[r-1] == runRelease[r], "the earliest deadline runs first");
+        together++;
+    }
+
+    check(together >= 3, "both tasks run");
+
+    printf("PASS\n");
+}
@@ -0,0 +1,219 @@
+/**
+  * Host test of the fiber scheduler.
+  *
+  * Runs the real scheduler on the host backend, and checks that fibers are created, paged, put to sleep, woken by
+  * events and forked on block just as they are on the device.
+  */
+
+#include "MicroBit.h"
+
+int started = 0;            // The number of fibers that have started running.
+int finished = 0;           // The number of fibers that have run to completion.
+int deepest = 0;            // The deepest recursion reached by a fiber with a dedicated stack.
+
+// Parameters passed between fibers. These can't live on the stack of a paged fiber, as only the stack of the running
+// fiber is present on the system stack.
+int results[4];
+uint16_t value = 1;
+int param = 7;
+
+FiberMutex mutex;           // Shared between the fibers that test its ownership.
+int unlocked;               // The result of the last call to mutex.unlock() made by a holder of the lock.
+
+/**
+  * Reports a failed check, and ends the test.
+  */
+void check(int condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        exit(1);
+    }
+}
+
+/**
+  * Fills some stack, so that it has to be paged correctly to survive a context switch.
+  */
+int recurse(int depth)
+{
+    volatile char buffer[64];
+
+    buffer[0] = (char) depth;
+
+    if (depth > 0)
+    {
+        fiber_sleep(1);
+        return recurse(depth - 1) + buffer[0];
+    }
+
+    return 0;
+}
+
+void sleeper(void *param)
+{
+    int *p = (int *) param;
+
+    started++;
+
+    // 10 + 9 + ... + 1 = 55, unless our stack was corrupted whilst we slept.
+    *p = recurse(10);
+
+    finished++;
+}
+
+void waiter(void *param)
+{
+    started++;
+
+    fiber_wait_for_event(MICROBIT_ID_NOTIFY, *(uint16_t *) param);
+
+    finished++;
+}
+
+void handler(void *param)
+{
+    volatile int local = 42;
+
+    // Block, so that invoke() has to fork a fiber to complete this call.
+    fiber_sleep(20);
+
+    check(local == 42, "locals of a forked handler survive");
+    check(*(int *) param == 7, "parameters of a forked handler survive");
+
+    finished++;
+}
+
+void dedicated(void *param)
+{
+    (void)param; /* -Wunused-parameter */
+
+    deepest = recurse(20);
+    finished++;
+}
+
+void holder(void *param)
+{
+    (void)param; /* -Wunused-parameter */
+
+    mutex.lock();
+    fiber_sleep(50);
+    unlocked = mutex.unlock();
+
+    finished++;
+}
+
+void lockingHandler(void *param)
+{
+    (void)param; /* -Wunused-parameter */
+
+    // Take the lock from fork on block context, then block whilst holding it.
+    mutex.lock();
+    fiber_sleep(20);
+    unlocked = mutex.unlock();
+
+    finished++;
+}
+
+void blockingDeferred(void *param)
+{
+    // Block, so the idle fiber has to hand the rest of this call to a fiber of its own.
+    fiber_sleep(20);
+
+    results[0] = *(int *) param;
+    finished++;
+}
+
+void deferred(void *param)
+{
+    results[1] = *(int *) param;
+    finished++;
+}
+
+void app_main()
+{
+    unsigned long start;
+
+    // Paged fibers, sleeping with a deep stack.
+    for (int i = 0; i < 4; i++)
+        check(create_fiber(sleeper, &results[i]) != NULL, "create_fiber");
+
+    start = uBit.systemTime();
+    uBit.sleep(100);
+
+    check(started == 4 && finished == 4, "paged fibers run to completion");
+
+    for (int i = 0; i < 4; i++)
+        check(results[i] == 55, "paged stacks are preserved");
+
+    // Time moves on at the rate of the system tick.
+    check(uBit.systemTime() - start >= 100, "fiber_sleep() waits for at least the given time");
+
+    // Fibers waiting on an event are woken only by that event.
+    started = finished = 0;
+
+    create_fiber(waiter, &value);
+    uBit.sleep(20);
+    check(started == 1 && finished == 0, "fiber_wait_for_event() blocks");
+
+    MicroBitEvent(MICROBIT_ID_NOTIFY, 2);
+    uBit.sleep(20);
+    check(finished == 0, "fiber_wait_for_event() ignores other events");
+
+    MicroBitEvent(MICROBIT_ID_NOTIFY, 1);
+    uBit.sleep(20);
+    check(finished == 1, "fiber_wait_for_event() wakes on its event");
+
+    // Fork on block.
+    finished = 0;
+
+    check(invoke(handler, &param) == MICROBIT_OK, "invoke");
+    check(finished == 0, "invoke() returns once its handler blocks");
+
+    uBit.sleep(100);
+    check(finished == 1, "forked handlers run to completion");
+
+    // Fibers with a dedicated stack.
+    finished = 0;
+
+    check(create_dedicated_fiber(dedicated, NULL, 4096) != NULL, "create_dedicated_fiber");
+
+    uBit.sleep(250);
+    check(finished == 1 && deepest == 210, "dedicated stacks are preserved");
+
+    // Only the fiber that holds a mutex may release it.
+    finished = 0;
+    unlocked = MICROBIT_NOT_SUPPORTED;
+
+    create_fiber(holder, NULL);
+    uBit.sleep(20);
+
+    check(mutex.unlock() == MICROBIT_NOT_SUPPORTED && mutex.isLocked(), "a mutex can't be released by another fiber");
+
+    uBit.sleep(100);
+    check(finished == 1 && unlocked == MICROBIT_OK && !mutex.isLocked(), "a mutex is released by its holder");
+
+    // Including when the lock was taken by a handler that went on to block.
+    finished = 0;
+    unlocked = MICROBIT_NOT_SUPPORTED;
+
+    check(invoke(lockingHandler, NULL) == MICROBIT_OK, "invoke");
+
+    uBit.sleep(100);
+    check(finished == 1 && unlocked == MICROBIT_OK && !mutex.isLocked(), "a mutex taken by a forked handler is released by it");
+
+    // Deferred calls that block don't take the idle fiber with them.
+    finished = 0;
+    results[0] = results[1] = 0;
+
+    check(scheduler_defer(blockingDeferred, &param) == MICROBIT_OK, "scheduler_defer");
+    check(scheduler_defer(deferred, &param) == MICROBIT_OK, "scheduler_defer");
+
+    uBit.sleep(5);
+    check(finished == 1 && results[1] == 7, "calls deferred after one that blocks still run");
+
+    uBit.sleep(100);
+    check(finished == 2 && results[0] == 7, "deferred calls that block run to completion");
+
+    printf("PASS\n");
+}
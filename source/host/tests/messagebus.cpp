@@ -0,0 +1,148 @@
+/**
+  * Host test of the message bus.
+  *
+  * Runs the real message bus and scheduler on the host backend, and checks that events reach the listeners
+  * registered for them, in each of the ways a listener can be run.
+  */
+
+#include "MicroBit.h"
+
+#define TEST_ID         8000
+
+int received[4];        // The number of events received by each handler.
+int lastValue;          // The value of the last event received by the blocking handler.
+int batches;            // The number of batches received by the batch handler.
+int batched;            // The number of events received by the batch handler.
+int dedicated;          // The number of events received by the handler with a dedicated fiber.
+int throttled;          // The number of events received by the throttled handler.
+
+/**
+  * Reports a failed check, and ends the test.
+  */
+void check(int condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        exit(1);
+    }
+}
+
+void onImmediate(MicroBitEvent evt)
+{
+    (void)evt; /* -Wunused-parameter */
+
+    check(inInterruptContext() == 0, "listeners are not run in interrupt context");
+    received[0]++;
+}
+
+void onQueued(MicroBitEvent evt, void *param)
+{
+    (void)evt; /* -Wunused-parameter */
+
+    check(param == &received[1], "parameterised listeners receive their parameter");
+    received[1]++;
+}
+
+void onBlocking(MicroBitEvent evt)
+{
+    // Block, so the message bus has to fork a fiber to run this handler to completion.
+    fiber_sleep(10);
+
+    lastValue = evt.value;
+    received[2]++;
+}
+
+void onAny(MicroBitEvent evt)
+{
+    (void)evt; /* -Wunused-parameter */
+
+    received[3]++;
+}
+
+void onBatch(MicroBitEvent *evt, int length, void *param)
+{
+    (void)evt; /* -Wunused-parameter */
+    (void)param; /* -Wunused-parameter */
+
+    batches++;
+    batched += length;
+}
+
+void onDedicated(MicroBitEvent evt)
+{
+    (void)evt; /* -Wunused-parameter */
+
+    fiber_sleep(1);
+    dedicated++;
+}
+
+void onThrottled(MicroBitEvent evt)
+{
+    (void)evt; /* -Wunused-parameter */
+
+    throttled++;
+}
+
+void app_main()
+{
+    check(uBit.MessageBus.listen(TEST_ID, 1, onImmediate, MESSAGE_BUS_LISTENER_IMMEDIATE) == MICROBIT_OK, "listen (immediate)");
+    check(uBit.MessageBus.listen(TEST_ID, 2, onQueued, &received[1]) == MICROBIT_OK, "listen (parameterised)");
+    check(uBit.MessageBus.listen(TEST_ID, 3, onBlocking) == MICROBIT_OK, "listen (blocking)");
+    check(uBit.MessageBus.listen(TEST_ID, MICROBIT_EVT_ANY, onAny) == MICROBIT_OK, "listen (any value)");
+
+    // Immediate listeners are run before the event is raised.
+    MicroBitEvent(TEST_ID, 1);
+    check(received[0] == 1, "immediate listeners are run as the event is raised");
+
+    // Other listeners are run from the event queue, once the idle thread has had a chance to run.
+    MicroBitEvent(TEST_ID, 2);
+    check(received[1] == 0, "queued listeners are not run as the event is raised");
+
+    uBit.sleep(20);
+    check(received[1] == 1, "queued listeners are run by the idle thread");
+
+    // Listeners that block are forked onto their own fiber, and each event is delivered in turn.
+    for (int i = 0; i < 3; i++)
+        MicroBitEvent(TEST_ID, 3);
+
+    uBit.sleep(100);
+    check(received[2] == 3 && lastValue == 3, "blocking listeners receive every event");
+
+    // Events from interrupt context are queued, and delivered just the same.
+    check(received[3] == 5, "MICROBIT_EVT_ANY listeners receive every event");
+
+    // Once ignored, a listener receives no more events.
+    check(uBit.MessageBus.ignore(TEST_ID, 2, onQueued) == MICROBIT_OK, "ignore");
+
+    MicroBitEvent(TEST_ID, 2);
+    uBit.sleep(20);
+    check(received[1] == 1, "ignored listeners receive no events");
+    check(received[3] == 6, "other listeners still receive events");
+
+    // Listeners that keep state of their own: batched, dedicated fiber and throttled.
+    check(uBit.MessageBus.listen(TEST_ID + 1, 1, onBatch, NULL) == MICROBIT_OK, "listen (batch)");
+    check(uBit.MessageBus.listen(TEST_ID + 1, 2, onDedicated, MESSAGE_BUS_LISTENER_DEDICATED_FIBER | MESSAGE_BUS_LISTENER_QUEUE_IF_BUSY) == MICROBIT_OK, "listen (dedicated fiber)");
+    check(uBit.MessageBus.listen(TEST_ID + 1, 3, onThrottled, MESSAGE_BUS_LISTENER_THROTTLE, 1000) == MICROBIT_OK, "listen (throttled)");
+
+    for (int i = 0; i < 3; i++)
+        MicroBitEvent(TEST_ID + 1, 1);
+
+    uBit.sleep(20);
+    check(batches == 1 && batched == 3, "batch listeners receive their events in a single call");
+
+    for (int i = 0; i < 3; i++)
+    {
+        MicroBitEvent(TEST_ID + 1, 2);
+        MicroBitEvent(TEST_ID + 1, 3);
+    }
+
+    uBit.sleep(100);
+    check(dedicated == 3, "listeners with a dedicated fiber receive every event");
+    check(throttled == 1, "throttled listeners receive one event per interval");
+
+    check(uBit.MessageBus.ignore(TEST_ID + 1, 2, onDedicated) == MICROBIT_OK, "ignore (dedicated fiber)");
+    uBit.sleep(20);
+
+    printf("PASS\n");
+}
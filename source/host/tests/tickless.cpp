@@ -0,0 +1,182 @@
+/**
+  * Host test of tickless idle.
+  *
+  * Checks that the system time keeps pace with real time, and that sleeping fibers and timers are woken on time,
+  * whilst the system tick is suspended. Also reports how many times the processor was woken, compared with the
+  * number of system ticks that would otherwise have been taken.
+  */
+
+#include "MicroBit.h"
+
+#if !CONFIG_ENABLED(MICROBIT_FIBER_TICKLESS)
+#error "This test requires MICROBIT_FIBER_TICKLESS"
+#endif
+
+#define TEST_ID             8000
+
+// The most a fiber may be woken after its deadline: the tick it is due on, and one more for scheduling jitter (ms).
+#define TEST_TOLERANCE      (2 * FIBER_TICK_PERIOD_MS)
+
+const unsigned long sleeps[3] = {100, 250, 400};        // The time for which each sleeper sleeps (ms).
+unsigned long woken[3];                                 // The delay between each sleeper's deadline and it waking (ms).
+unsigned long timerWoken;                               // The system time at which the timer event was received.
+unsigned long deferredRun;                              // The system time at which the deferred call was run.
+
+/**
+  * A system component that checks it is only ever called from interrupt context, as the system tick (including
+  * the tick that catches up after a tickless sleep) must be.
+  */
+class TickMonitor : public MicroBitComponent
+{
+    public:
+
+    int ticks;              // The number of system ticks received.
+    int threadTicks;        // The number of those received outside interrupt context.
+
+    virtual void systemTick()
+    {
+        ticks++;
+
+        if (!inInterruptContext())
+            threadTicks++;
+    }
+
+    virtual unsigned long nextSystemTick()
+    {
+        return MICROBIT_SYSTEM_TICK_NONE;
+    }
+};
+
+TickMonitor monitor;
+
+void onDeferred(void *param);
+
+/**
+  * A system component that hands off work as an interrupt handler would, just as the idle thread is deciding how long
+  * to sleep for (after it has checked for deferred calls).
+  */
+class LateInterrupt : public MicroBitComponent
+{
+    public:
+
+    int armed;              // Set to defer a call the next time the idle thread asks when we next need a tick.
+
+    virtual unsigned long nextSystemTick()
+    {
+        if (armed)
+        {
+            armed = 0;
+            scheduler_defer(onDeferred, NULL);
+        }
+
+        return MICROBIT_SYSTEM_TICK_NONE;
+    }
+};
+
+LateInterrupt late;
+
+/**
+  * Reports a failed check, and ends the test.
+  */
+void check(int condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        exit(1);
+    }
+}
+
+/**
+  * Determines the real time, as measured by the host.
+  * @return The time since an arbitrary epoch, in milliseconds.
+  */
+unsigned long realTime()
+{
+    return us_ticker_read() / 1000;
+}
+
+void sleeper(void *param)
+{
+    int i = (int)(intptr_t) param;
+    unsigned long deadline = ticks + sleeps[i];
+
+    fiber_sleep(sleeps[i]);
+
+    woken[i] = ticks - deadline;
+}
+
+void onTimer(MicroBitEvent)
+{
+    timerWoken = ticks;
+}
+
+void onDeferred(void *param)
+{
+    (void)param; /* -Wunused-parameter */
+
+    deferredRun = ticks;
+}
+
+void app_main()
+{
+    unsigned long start, realStart, elapsed, realElapsed;
+    uint32_t interrupts;
+
+    uBit.addSystemComponent(&monitor);
+
+    // Let the scheduler settle.
+    uBit.sleep(50);
+
+    // A single long sleep, with nothing else to do.
+    start = ticks;
+    realStart = realTime();
+    interrupts = microbit_host_irq_count;
+
+    uBit.sleep(1000);
+
+    elapsed = ticks - start;
+    realElapsed = realTime() - realStart;
+    interrupts = microbit_host_irq_count - interrupts;
+
+    check(elapsed >= 1000 && elapsed <= 1000 + TEST_TOLERANCE, "fiber_sleep() wakes on time");
+    check(realElapsed + TEST_TOLERANCE >= elapsed && realElapsed <= elapsed + TEST_TOLERANCE, "the system time keeps pace with real time");
+    check(interrupts < elapsed / FIBER_TICK_PERIOD_MS / 10, "the system tick is suspended");
+
+    printf("slept for %lu ms (real time %lu ms), woken %lu times; %lu ticks would otherwise have been taken\n",
+        elapsed, realElapsed, (unsigned long) interrupts, elapsed / FIBER_TICK_PERIOD_MS);
+
+    printf("wakeups per minute: %lu tickless, %lu ticking\n",
+        (unsigned long) interrupts * 60000 / elapsed, 60000UL / FIBER_TICK_PERIOD_MS);
+
+    // Several fibers with different deadlines, each of which needs to be woken on time.
+    for (int i = 0; i < 3; i++)
+        create_fiber(sleeper, (void *)(intptr_t) i);
+
+    uBit.sleep(500);
+
+    for (int i = 0; i < 3; i++)
+        check(woken[i] <= TEST_TOLERANCE, "sleeping fibers wake on time");
+
+    // Timers need waking for too.
+    uBit.MessageBus.listen(TEST_ID, 1, onTimer, MESSAGE_BUS_LISTENER_IMMEDIATE);
+
+    start = ticks;
+    uBit.timer.eventAfter(300, TEST_ID, 1);
+    uBit.sleep(1000);
+
+    check(timerWoken - start >= 300 && timerWoken - start <= 300 + TEST_TOLERANCE, "timers fire on time");
+
+    // Work handed off by an interrupt just before the processor goes to sleep mustn't be left until it next wakes.
+    uBit.addSystemComponent(&late);
+
+    start = ticks;
+    late.armed = 1;
+    uBit.sleep(1000);
+
+    check(late.armed == 0 && deferredRun - start <= TEST_TOLERANCE, "work handed off as the processor goes to sleep is done straight away");
+
+    check(monitor.ticks > 0 && monitor.threadTicks == 0, "the system tick is only delivered from interrupt context");
+
+    printf("PASS\n");
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Decodes a message bus event trace, as sent by MicroBitSerial::sendEventTrace(),
+and prints it as a timeline.
+
+Usage:
+    decode_event_trace.py trace.bin
+    decode_event_trace.py /dev/ttyACM0      (requires pyserial)
+
+The input may contain other serial output; everything before the "MBTR" header is ignored.
+"""
+
+import struct
+import sys
+
+MAGIC = b"MBTR"
+HEADER = struct.Struct("<4sBBH")
+RECORD = struct.Struct("<IHHHBB")
+
+TYPES = {
+    1: "send",
+    2: "process",
+    3: "urgent",
+}
+
+
+def read_source(path):
+    """Reads the raw trace, from either a file or a serial port."""
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial
+
+        with serial.Serial(path, 115200, timeout=2) as port:
+            data = b""
+            while True:
+                chunk = port.read(1024)
+                if not chunk:
+                    return data
+                data += chunk
+
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def decode(data):
+    """Yields each trace record in the data, as a tuple of its fields."""
+    start = data.find(MAGIC)
+    if start < 0:
+        raise ValueError("no event trace found")
+
+    magic, version, size, count = HEADER.unpack_from(data, start)
+    if version != 1 or size != RECORD.size:
+        raise ValueError("unsupported trace format (version %d, record size %d)" % (version, size))
+
+    offset = start + HEADER.size
+    for _ in range(count):
+        if offset + size > len(data):
+            raise ValueError("trace truncated")
+
+        yield RECORD.unpack_from(data, offset)
+        offset += size
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    first = None
+    previous = None
+
+    print("%12s %10s  %-8s %6s %6s %10s %9s" % ("time (us)", "delta", "type", "source", "value", "duration", "listeners"))
+
+    for timestamp, source, value, duration, listeners, kind in decode(read_source(argv[1])):
+        if first is None:
+            first = previous = timestamp
+
+        # Timestamps are taken from a 32 bit microsecond counter, so allow for it wrapping.
+        elapsed = (timestamp - first) & 0xFFFFFFFF
+        delta = (timestamp - previous) & 0xFFFFFFFF
+        previous = timestamp
+
+        print("%12d %+10d  %-8s %6d %6d %10s %9s" % (
+            elapsed,
+            delta,
+            TYPES.get(kind, "?%d" % kind),
+            source,
+            value,
+            "" if kind == 1 else "%d%s" % (duration, "+" if duration == 0xFFFF else ""),
+            "" if kind == 1 else "%d" % listeners))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))